@@ -108,6 +108,9 @@ BOARD_HAVE_MTK_FM := true
 
 # Power
 TARGET_TAP_TO_WAKE_NODE := "/sys/touchpanel/double_tap"
+SOONG_CONFIG_NAMESPACES += MT6768_POWER
+SOONG_CONFIG_MT6768_POWER := TAP_TO_WAKE_NODE
+SOONG_CONFIG_MT6768_POWER_TAP_TO_WAKE_NODE := $(TARGET_TAP_TO_WAKE_NODE)
 
 # Properties
 TARGET_SYSTEM_PROP += $(COMMON_PATH)/system.prop
@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_AUTHTOKENBUFFER_H
+#define ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_AUTHTOKENBUFFER_H
+
+#include <hardware/hw_auth_token.h>
+#include <hidl/HidlSupport.h>
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+
+/*
+ * Hands an auth token to onAuthenticated() without touching the heap.
+ *
+ * The returned hidl_vec points into this object, so it only stays valid
+ * until the next lend() and the buffer must only be used by one thread.
+ */
+class AuthTokenBuffer {
+  public:
+    const hidl_vec<uint8_t>& lend(const hw_auth_token_t& hat) {
+        mToken = hat;
+        mVec.setToExternal(reinterpret_cast<uint8_t*>(&mToken), sizeof(mToken));
+        return mVec;
+    }
+
+  private:
+    hw_auth_token_t mToken;
+    hidl_vec<uint8_t> mVec;
+};
+
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_AUTHTOKENBUFFER_H
@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "AuthTokenBuffer.h"
+#include "BoundedQueue.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+#include <arpa/inet.h>
+
+// Counts every allocation in the process, tests compare it around the code
+// they check so gtest's own allocations don't matter
+static std::atomic<size_t> sAllocations{0};
+
+void* operator new(size_t size) {
+    sAllocations++;
+    if (void* p = malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    free(p);
+}
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+
+namespace {
+
+// What the dispatcher carries for an authenticated message
+struct AuthEvent {
+    uint32_t fid;
+    uint32_t gid;
+    hw_auth_token_t hat;
+};
+
+hw_auth_token_t makeToken(uint64_t challenge) {
+    hw_auth_token_t hat = {};
+
+    hat.version = HW_AUTH_TOKEN_VERSION;
+    hat.challenge = challenge;
+    hat.user_id = 10;
+    hat.authenticator_id = 0x1234;
+    hat.authenticator_type = htonl(HW_AUTH_FINGERPRINT);
+    hat.timestamp = challenge * 1000;
+    memset(hat.hmac, int(challenge), sizeof(hat.hmac));
+    return hat;
+}
+
+// Stands in for the client callback, keeps what it was handed on the stack
+struct Client {
+    uint8_t last[sizeof(hw_auth_token_t)];
+    size_t calls = 0;
+
+    void onAuthenticated(uint32_t, uint32_t, const hidl_vec<uint8_t>& token) {
+        memcpy(last, token.data(), std::min(token.size(), sizeof(last)));
+        calls++;
+    }
+};
+
+}  // anonymous namespace
+
+TEST(AuthTokenBufferTest, CounterSeesTheOldPath) {
+    hw_auth_token_t hat = makeToken(1);
+    const uint8_t* bytes = reinterpret_cast<const uint8_t*>(&hat);
+
+    size_t before = sAllocations;
+    {
+        const hidl_vec<uint8_t> token(std::vector<uint8_t>(bytes, bytes + sizeof(hat)));
+    }
+    size_t allocations = sAllocations - before;
+
+    // The vector and the hidl_vec copy of it
+    EXPECT_EQ(allocations, 2u);
+}
+
+TEST(AuthTokenBufferTest, LendsTheToken) {
+    AuthTokenBuffer buffer;
+    hw_auth_token_t hat = makeToken(42);
+
+    const hidl_vec<uint8_t>& token = buffer.lend(hat);
+
+    ASSERT_EQ(token.size(), sizeof(hat));
+    EXPECT_EQ(memcmp(token.data(), &hat, sizeof(hat)), 0);
+
+    // The next token replaces the last one in place
+    hw_auth_token_t next = makeToken(43);
+    buffer.lend(next);
+    EXPECT_EQ(memcmp(token.data(), &next, sizeof(next)), 0);
+}
+
+TEST(AuthTokenBufferTest, AuthenticateCycleDoesNotAllocate) {
+    BoundedQueue<AuthEvent, 64> events;
+    AuthTokenBuffer buffer;
+    Client client;
+    AuthEvent event = {};
+    bool mismatch = false;
+
+    // Warm up once, then count a run of unlocks
+    events.push({1, 0, makeToken(0)});
+    events.pop(&event);
+    client.onAuthenticated(event.fid, event.gid, buffer.lend(event.hat));
+
+    size_t before = sAllocations;
+    for (uint64_t i = 1; i <= 1000; i++) {
+        // notify() on the vendor library thread
+        events.push({1, 0, makeToken(i)});
+
+        // dispatch() on the callback thread
+        while (events.pop(&event)) {
+            client.onAuthenticated(event.fid, event.gid, buffer.lend(event.hat));
+        }
+
+        hw_auth_token_t expected = makeToken(i);
+        mismatch |= memcmp(client.last, &expected, sizeof(expected)) != 0;
+    }
+    size_t allocations = sAllocations - before;
+
+    EXPECT_EQ(allocations, 0u);
+    EXPECT_EQ(client.calls, 1001u);
+    EXPECT_FALSE(mismatch);
+}
+
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
@@ -15,8 +15,15 @@
 #include "BiometricsFingerprint.h"
 
 #include <inttypes.h>
+#include <string.h>
+#include <sys/eventfd.h>
 #include <unistd.h>
 
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+
 
 namespace {
 
@@ -33,6 +40,15 @@ std::string FpHalToString(FpHal hal) {
     }
 }
 
+FpHal FpHalFromString(const std::string& name) {
+    for (auto const& pair : fpHals) {
+        if (FpHalToString(pair.first) == name) {
+            return pair.first;
+        }
+    }
+    return FpHal::UNKNOWN;
+}
+
 } // anonymous namespace
 
 namespace android {
@@ -45,35 +61,139 @@ namespace implementation {
 // Supported fingerprint HAL version
 static const uint16_t kVersion = HARDWARE_MODULE_API_VERSION(2, 1);
 
+// How long a full probe waits for the vendor libraries to come up
+static const std::chrono::milliseconds kProbeTimeout(3000);
+
+// Goodix reports the finger touching the sensor as a vendor acquired code
+static const int32_t kGoodixAcquiredFingerDown = 22;
+
 using RequestStatus =
         android::hardware::biometrics::fingerprint::V2_1::RequestStatus;
 
 BiometricsFingerprint *BiometricsFingerprint::sInstance = nullptr;
 
-BiometricsFingerprint::BiometricsFingerprint() : mClientCallback(nullptr), mDevice(nullptr) {
+BiometricsFingerprint::BiometricsFingerprint()
+    : mEventFd(eventfd(0, EFD_CLOEXEC)),
+      mDispatcherStop(false),
+      mDroppedAcquired(0),
+      mQueueFullStalls(0),
+      mMaxQueueDepth(0),
+      mAuthCount(0),
+      mAuthLatencyLastNs(0),
+      mAuthLatencyTotalNs(0),
+      mAuthLatencyMaxNs(0),
+      mUdfps(android::base::GetBoolProperty("ro.vendor.fps_hal.udfps", false)),
+      mCapturing(false),
+      mFingerDowns(0),
+      mFingerDownsIdle(0),
+      mClientCallback(nullptr),
+      mDevice(nullptr),
+      currentHal(FpHal::UNKNOWN) {
     sInstance = this; // keep track of the most recent instance
 
-    for (auto const& pair : fpHals) {
-        ALOGI("Trying to open HAL module %s", pair.second.c_str());
-        mDevice = openHal(pair.second);
+    // Framework callbacks run on their own thread so a slow system_server
+    // never stalls the vendor library thread that calls notify().
+    mDispatcher = std::thread(&BiometricsFingerprint::dispatchLoop, this);
+
+    auto start = std::chrono::steady_clock::now();
+    const char* method = "cached";
+
+    // Try the module that worked last boot before paying for failed
+    // dlopen()s and device opens of the others.
+    FpHal cached = FpHalFromString(
+            android::base::GetProperty("persist.vendor.sys.fp.vendor", ""));
+    if (cached != FpHal::UNKNOWN) {
+        ALOGI("Trying to open cached HAL module %s", fpHals[cached].c_str());
+        mDevice = openHal(fpHals[cached]);
         if (mDevice) {
-            ALOGI("Opened HW module %s", pair.second.c_str());
-            currentHal = pair.first;
-            break;
+            currentHal = cached;
         } else {
-            ALOGE("Can't open HAL module %s", pair.second.c_str());
+            ALOGE("Can't open cached HAL module %s", fpHals[cached].c_str());
         }
     }
 
     if (!mDevice) {
+        method = "probe";
+        probeHals(cached);
+    }
+
+    if (mDevice) {
+        ALOGI("Opened HW module %s", fpHals[currentHal].c_str());
+    } else {
         ALOGE("Failed to open any HW modules!");
     }
 
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+    ALOGI("HAL selection (%s) took %lld ms", method, static_cast<long long>(elapsed.count()));
+    android::base::SetProperty("vendor.fps_hal.probe_ms", std::to_string(elapsed.count()));
+
     android::base::SetProperty("persist.vendor.sys.fp.vendor", FpHalToString(currentHal));
+
+    if (currentHal == FpHal::GOODIX) {
+        mGoodixExt = std::make_unique<GoodixExtBridge>();
+    }
+}
+
+void BiometricsFingerprint::probeHals(FpHal skip) {
+    struct ProbeState {
+        std::mutex lock;
+        std::condition_variable cv;
+        fingerprint_device_t* device = nullptr;
+        bool done = false;
+        bool abandoned = false;
+    };
+    auto deadline = std::chrono::steady_clock::now() + kProbeTimeout;
+
+    // The modules share the SPI bus and the reset GPIOs, so they are opened
+    // one at a time. Each open still runs on its own thread so a wedged
+    // vendor library can't hold up the service past the timeout; nothing
+    // else is probed after that, and the straggler closes whatever it opens.
+    for (auto const& pair : fpHals) {
+        if (pair.first == skip) {
+            continue;
+        }
+
+        auto state = std::make_shared<ProbeState>();
+        std::thread([state, name = pair.second] {
+            ALOGI("Trying to open HAL module %s", name.c_str());
+            fingerprint_device_t* device = openHal(name);
+            if (!device) {
+                ALOGE("Can't open HAL module %s", name.c_str());
+            }
+
+            std::lock_guard<std::mutex> lock(state->lock);
+            if (state->abandoned) {
+                if (device) {
+                    ALOGW("HAL module %s opened after the probe timed out", name.c_str());
+                    device->common.close(reinterpret_cast<hw_device_t*>(device));
+                }
+                return;
+            }
+            state->device = device;
+            state->done = true;
+            state->cv.notify_all();
+        }).detach();
+
+        std::unique_lock<std::mutex> lock(state->lock);
+        if (!state->cv.wait_until(lock, deadline, [&] { return state->done; })) {
+            ALOGE("Timed out probing HAL module %s", pair.second.c_str());
+            state->abandoned = true;
+            return;
+        }
+        if (state->device) {
+            mDevice = state->device;
+            currentHal = pair.first;
+            return;
+        }
+    }
 }
 
 BiometricsFingerprint::~BiometricsFingerprint() {
     ALOGV("~BiometricsFingerprint()");
+    mDispatcherStop = true;
+    eventfd_write(mEventFd, 1);
+    mDispatcher.join();
     if (mDevice == nullptr) {
         ALOGE("No valid device");
         return;
@@ -167,10 +287,27 @@ FingerprintAcquiredInfo BiometricsFingerprint::VendorAcquiredFilter(
     return FingerprintAcquiredInfo::ACQUIRED_INSUFFICIENT;
 }
 
+// Promote the Goodix vendor codes that have a 2.2 equivalent, leave the
+// already translated acquired info alone otherwise. A promoted code is no
+// longer a vendor message, so its vendor code is cleared.
+int32_t BiometricsFingerprint::GoodixAcquiredFilter(int32_t info, int32_t* vendorCode) {
+    if (info != static_cast<int32_t>(FingerprintAcquiredInfo::ACQUIRED_VENDOR)) {
+        return info;
+    }
+    switch(*vendorCode) {
+        case kGoodixAcquiredFingerDown:
+            *vendorCode = 0;
+            return static_cast<int32_t>(FingerprintAcquiredInfo_2_2::START);
+        default:
+            return info;
+    }
+}
+
 Return<uint64_t> BiometricsFingerprint::setNotify(
         const sp<IBiometricsFingerprintClientCallback>& clientCallback) {
     std::lock_guard<std::mutex> lock(mClientCallbackMutex);
     mClientCallback = clientCallback;
+    mClientCallback_2_2 = IBiometricsFingerprintClientCallback_2_2::castFrom(clientCallback);
     // This is here because HAL 2.1 doesn't have a way to propagate a
     // unique token for its driver. Subsequent versions should send a unique
     // token for each call to setNotify(). This is fine as long as there's only
@@ -186,7 +323,9 @@ Return<RequestStatus> BiometricsFingerprint::enroll(const hidl_array<uint8_t, 69
         uint32_t gid, uint32_t timeoutSec) {
     const hw_auth_token_t* authToken =
         reinterpret_cast<const hw_auth_token_t*>(hat.data());
-    return ErrorFilter(mDevice->enroll(mDevice, authToken, gid, timeoutSec));
+    int32_t ret = mDevice->enroll(mDevice, authToken, gid, timeoutSec);
+    mCapturing = ret == 0;
+    return ErrorFilter(ret);
 }
 
 Return<RequestStatus> BiometricsFingerprint::postEnroll() {
@@ -198,6 +337,7 @@ Return<uint64_t> BiometricsFingerprint::getAuthenticatorId() {
 }
 
 Return<RequestStatus> BiometricsFingerprint::cancel() {
+    mCapturing = false;
     return ErrorFilter(mDevice->cancel(mDevice));
 }
 
@@ -225,10 +365,32 @@ Return<RequestStatus> BiometricsFingerprint::setActiveGroup(uint32_t gid,
 
 Return<RequestStatus> BiometricsFingerprint::authenticate(uint64_t operationId,
         uint32_t gid) {
-    return ErrorFilter(mDevice->authenticate(mDevice, operationId, gid));
+    int32_t ret = mDevice->authenticate(mDevice, operationId, gid);
+    mCapturing = ret == 0;
+    return ErrorFilter(ret);
 }
 
-IBiometricsFingerprint* BiometricsFingerprint::getInstance() {
+Return<bool> BiometricsFingerprint::isUdfps(uint32_t /* sensorId */) {
+    return mUdfps;
+}
+
+Return<void> BiometricsFingerprint::onFingerDown(uint32_t /* x */, uint32_t /* y */,
+        float /* minor */, float /* major */) {
+    // Only a hint. The sensor is armed by authenticate(), which carries the
+    // operation id the auth token has to be bound to; a finger down with no
+    // capture running means that call came in late.
+    mFingerDowns++;
+    if (!mCapturing) {
+        mFingerDownsIdle++;
+    }
+    return Void();
+}
+
+Return<void> BiometricsFingerprint::onFingerUp() {
+    return Void();
+}
+
+IBiometricsFingerprint_2_3* BiometricsFingerprint::getInstance() {
     if (!sInstance) {
       sInstance = new BiometricsFingerprint();
     }
@@ -284,76 +446,180 @@ fingerprint_device_t* BiometricsFingerprint::openHal(std::string hal) {
 void BiometricsFingerprint::notify(const fingerprint_msg_t *msg) {
     BiometricsFingerprint* thisPtr = static_cast<BiometricsFingerprint*>(
             BiometricsFingerprint::getInstance());
-    std::lock_guard<std::mutex> lock(thisPtr->mClientCallbackMutex);
-    if (thisPtr == nullptr || thisPtr->mClientCallback == nullptr) {
+    FingerprintEvent event = {};
+
+    event.type = msg->type;
+    event.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    switch (msg->type) {
+        case FINGERPRINT_ERROR:
+            event.info = static_cast<int32_t>(
+                    VendorErrorFilter(msg->data.error, &event.vendorCode));
+            thisPtr->mCapturing = false;
+            break;
+        case FINGERPRINT_ACQUIRED:
+            event.info = static_cast<int32_t>(
+                    VendorAcquiredFilter(msg->data.acquired.acquired_info, &event.vendorCode));
+            if (thisPtr->currentHal == FpHal::GOODIX) {
+                event.info = GoodixAcquiredFilter(event.info, &event.vendorCode);
+            }
+            break;
+        case FINGERPRINT_TEMPLATE_ENROLLING:
+            event.fid = msg->data.enroll.finger.fid;
+            event.gid = msg->data.enroll.finger.gid;
+            event.remaining = msg->data.enroll.samples_remaining;
+            if (event.remaining == 0) {
+                thisPtr->mCapturing = false;
+            }
+            break;
+        case FINGERPRINT_TEMPLATE_REMOVED:
+            event.fid = msg->data.removed.finger.fid;
+            event.gid = msg->data.removed.finger.gid;
+            event.remaining = msg->data.removed.remaining_templates;
+            break;
+        case FINGERPRINT_AUTHENTICATED:
+            event.fid = msg->data.authenticated.finger.fid;
+            event.gid = msg->data.authenticated.finger.gid;
+            event.hat = msg->data.authenticated.hat;
+            if (event.fid != 0) {
+                thisPtr->mCapturing = false;
+            }
+            break;
+        case FINGERPRINT_TEMPLATE_ENUMERATING:
+            event.fid = msg->data.enumerated.finger.fid;
+            event.gid = msg->data.enumerated.finger.gid;
+            event.remaining = msg->data.enumerated.remaining_templates;
+            break;
+        default:
+            return;
+    }
+
+    thisPtr->queueEvent(event);
+}
+
+void BiometricsFingerprint::queueEvent(const FingerprintEvent& event) {
+    // ACQUIRED is advisory and arrives in bursts, so keep half of the queue
+    // free for the events the framework has to see.
+    if (event.type == FINGERPRINT_ACQUIRED && mEvents.size() >= mEvents.capacity() / 2) {
+        mDroppedAcquired++;
+        return;
+    }
+
+    // The dispatcher is stuck in a framework callback, push back on the
+    // vendor library rather than lose an event.
+    while (!mEvents.push(event)) {
+        mQueueFullStalls++;
+        usleep(1000);
+    }
+
+    uint64_t depth = mEvents.size();
+    uint64_t max = mMaxQueueDepth.load(std::memory_order_relaxed);
+    while (depth > max && !mMaxQueueDepth.compare_exchange_weak(max, depth)) {
+    }
+
+    eventfd_write(mEventFd, 1);
+}
+
+void BiometricsFingerprint::dispatchLoop() {
+    FingerprintEvent event;
+    eventfd_t unused;
+
+    while (!mDispatcherStop) {
+        if (eventfd_read(mEventFd, &unused) != 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            ALOGE("Failed to wait for fingerprint events: %s", strerror(errno));
+            return;
+        }
+
+        while (mEvents.pop(&event)) {
+            dispatch(event);
+        }
+    }
+}
+
+void BiometricsFingerprint::dispatch(const FingerprintEvent& event) {
+    sp<IBiometricsFingerprintClientCallback> callback;
+    sp<IBiometricsFingerprintClientCallback_2_2> callback_2_2;
+    {
+        std::lock_guard<std::mutex> lock(mClientCallbackMutex);
+        callback = mClientCallback;
+        callback_2_2 = mClientCallback_2_2;
+    }
+    if (callback == nullptr) {
         ALOGE("Receiving callbacks before the client callback is registered.");
         return;
     }
-    const uint64_t devId = reinterpret_cast<uint64_t>(thisPtr->mDevice);
-    switch (msg->type) {
+    const uint64_t devId = reinterpret_cast<uint64_t>(mDevice);
+    switch (event.type) {
         case FINGERPRINT_ERROR: {
-                int32_t vendorCode = 0;
-                FingerprintError result = VendorErrorFilter(msg->data.error, &vendorCode);
+                FingerprintError result = static_cast<FingerprintError>(event.info);
                 ALOGD("onError(%d)", result);
-                if (!thisPtr->mClientCallback->onError(devId, result, vendorCode).isOk()) {
+                if (!callback->onError(devId, result, event.vendorCode).isOk()) {
                     ALOGE("failed to invoke fingerprint onError callback");
                 }
             }
             break;
         case FINGERPRINT_ACQUIRED: {
-                int32_t vendorCode = 0;
-                FingerprintAcquiredInfo result =
-                    VendorAcquiredFilter(msg->data.acquired.acquired_info, &vendorCode);
+                FingerprintAcquiredInfo_2_2 result =
+                        static_cast<FingerprintAcquiredInfo_2_2>(event.info);
                 ALOGD("onAcquired(%d)", result);
-                if (!thisPtr->mClientCallback->onAcquired(devId, result, vendorCode).isOk()) {
-                    ALOGE("failed to invoke fingerprint onAcquired callback");
+                if (callback_2_2 != nullptr) {
+                    if (!callback_2_2->onAcquired_2_2(devId, result, event.vendorCode).isOk()) {
+                        ALOGE("failed to invoke fingerprint onAcquired_2_2 callback");
+                    }
+                } else {
+                    // START only exists from 2.2 on, older clients get the
+                    // Goodix vendor code it was promoted from.
+                    FingerprintAcquiredInfo info = result == FingerprintAcquiredInfo_2_2::START
+                            ? FingerprintAcquiredInfo::ACQUIRED_VENDOR
+                            : static_cast<FingerprintAcquiredInfo>(result);
+                    if (!callback->onAcquired(devId, info, event.vendorCode).isOk()) {
+                        ALOGE("failed to invoke fingerprint onAcquired callback");
+                    }
                 }
             }
             break;
         case FINGERPRINT_TEMPLATE_ENROLLING:
             ALOGD("onEnrollResult(fid=%d, gid=%d, rem=%d)",
-                msg->data.enroll.finger.fid,
-                msg->data.enroll.finger.gid,
-                msg->data.enroll.samples_remaining);
-            if (!thisPtr->mClientCallback->onEnrollResult(devId,
-                    msg->data.enroll.finger.fid,
-                    msg->data.enroll.finger.gid,
-                    msg->data.enroll.samples_remaining).isOk()) {
+                event.fid, event.gid, event.remaining);
+            if (!callback->onEnrollResult(devId,
+                    event.fid, event.gid, event.remaining).isOk()) {
                 ALOGE("failed to invoke fingerprint onEnrollResult callback");
             }
             break;
         case FINGERPRINT_TEMPLATE_REMOVED:
             ALOGD("onRemove(fid=%d, gid=%d, rem=%d)",
-                msg->data.removed.finger.fid,
-                msg->data.removed.finger.gid,
-                msg->data.removed.remaining_templates);
-            if (!thisPtr->mClientCallback->onRemoved(devId,
-                    msg->data.removed.finger.fid,
-                    msg->data.removed.finger.gid,
-                    msg->data.removed.remaining_templates).isOk()) {
+                event.fid, event.gid, event.remaining);
+            if (!callback->onRemoved(devId,
+                    event.fid, event.gid, event.remaining).isOk()) {
                 ALOGE("failed to invoke fingerprint onRemoved callback");
             }
             break;
         case FINGERPRINT_AUTHENTICATED:
-            if (msg->data.authenticated.finger.fid != 0) {
-                ALOGD("onAuthenticated(fid=%d, gid=%d)",
-                    msg->data.authenticated.finger.fid,
-                    msg->data.authenticated.finger.gid);
-                const uint8_t* hat =
-                    reinterpret_cast<const uint8_t *>(&msg->data.authenticated.hat);
-                const hidl_vec<uint8_t> token(
-                    std::vector<uint8_t>(hat, hat + sizeof(msg->data.authenticated.hat)));
-                if (!thisPtr->mClientCallback->onAuthenticated(devId,
-                        msg->data.authenticated.finger.fid,
-                        msg->data.authenticated.finger.gid,
-                        token).isOk()) {
+            if (event.fid != 0) {
+                ALOGD("onAuthenticated(fid=%d, gid=%d)", event.fid, event.gid);
+                // Lend the token from a buffer only the dispatcher touches
+                // instead of allocating a vector for every unlock.
+                if (!callback->onAuthenticated(devId, event.fid, event.gid,
+                        mAuthToken.lend(event.hat)).isOk()) {
                     ALOGE("failed to invoke fingerprint onAuthenticated callback");
                 }
+
+                int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now().time_since_epoch()).count();
+                int64_t latency = now - event.timestampNs;
+                mAuthCount++;
+                mAuthLatencyLastNs = latency;
+                mAuthLatencyTotalNs += latency;
+                if (latency > mAuthLatencyMaxNs) {
+                    mAuthLatencyMaxNs = latency;
+                }
             } else {
                 // Not a recognized fingerprint
-                if (!thisPtr->mClientCallback->onAuthenticated(devId,
-                        msg->data.authenticated.finger.fid,
-                        msg->data.authenticated.finger.gid,
+                if (!callback->onAuthenticated(devId, event.fid, event.gid,
                         hidl_vec<uint8_t>()).isOk()) {
                     ALOGE("failed to invoke fingerprint onAuthenticated callback");
                 }
@@ -361,19 +627,44 @@ void BiometricsFingerprint::notify(const fingerprint_msg_t *msg) {
             break;
         case FINGERPRINT_TEMPLATE_ENUMERATING:
             ALOGD("onEnumerate(fid=%d, gid=%d, rem=%d)",
-                msg->data.enumerated.finger.fid,
-                msg->data.enumerated.finger.gid,
-                msg->data.enumerated.remaining_templates);
-            if (!thisPtr->mClientCallback->onEnumerate(devId,
-                    msg->data.enumerated.finger.fid,
-                    msg->data.enumerated.finger.gid,
-                    msg->data.enumerated.remaining_templates).isOk()) {
+                event.fid, event.gid, event.remaining);
+            if (!callback->onEnumerate(devId,
+                    event.fid, event.gid, event.remaining).isOk()) {
                 ALOGE("failed to invoke fingerprint onEnumerate callback");
             }
             break;
+        default:
+            break;
     }
 }
 
+Return<void> BiometricsFingerprint::debug(const hidl_handle& handle,
+        const hidl_vec<hidl_string>& /* args */) {
+    if (handle == nullptr || handle->numFds < 1) {
+        return Void();
+    }
+
+    int fd = handle->data[0];
+    uint64_t authCount = mAuthCount;
+
+    dprintf(fd, "HAL: %s\n", FpHalToString(currentHal).c_str());
+    dprintf(fd, "Queued events: %zu (max %" PRIu64 " of %zu)\n",
+            mEvents.size(), mMaxQueueDepth.load(), mEvents.capacity());
+    dprintf(fd, "Dropped acquired events: %" PRIu64 "\n", mDroppedAcquired.load());
+    dprintf(fd, "Queue full stalls: %" PRIu64 "\n", mQueueFullStalls.load());
+    dprintf(fd, "Finger downs: %" PRIu64 " (%" PRIu64 " before authenticate)\n",
+            mFingerDowns.load(), mFingerDownsIdle.load());
+    dprintf(fd, "Authenticated to callback: count=%" PRIu64 " last=%" PRId64 "us avg=%" PRId64
+            "us max=%" PRId64 "us\n", authCount, mAuthLatencyLastNs.load() / 1000,
+            authCount ? mAuthLatencyTotalNs.load() / int64_t(authCount) / 1000 : 0,
+            mAuthLatencyMaxNs.load() / 1000);
+    if (mGoodixExt) {
+        mGoodixExt->dump(fd);
+    }
+
+    return Void();
+}
+
 } // namespace implementation
 }  // namespace V2_1
 }  // namespace fingerprint
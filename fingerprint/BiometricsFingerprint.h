@@ -11,9 +11,20 @@
 #include <android/log.h>
 #include <hardware/hardware.h>
 #include <hardware/fingerprint.h>
+#include <hardware/hw_auth_token.h>
 #include <hidl/MQDescriptor.h>
 #include <hidl/Status.h>
-#include <android/hardware/biometrics/fingerprint/2.1/IBiometricsFingerprint.h>
+#include <android/hardware/biometrics/fingerprint/2.3/IBiometricsFingerprint.h>
+#include <android/hardware/biometrics/fingerprint/2.2/IBiometricsFingerprintClientCallback.h>
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "AuthTokenBuffer.h"
+#include "BoundedQueue.h"
+#include "GoodixExtBridge.h"
 
 namespace {
 
@@ -32,22 +43,43 @@ namespace fingerprint {
 namespace V2_1 {
 namespace implementation {
 
-using ::android::hardware::biometrics::fingerprint::V2_1::IBiometricsFingerprint;
+using IBiometricsFingerprint_2_3 =
+        ::android::hardware::biometrics::fingerprint::V2_3::IBiometricsFingerprint;
 using ::android::hardware::biometrics::fingerprint::V2_1::IBiometricsFingerprintClientCallback;
+using IBiometricsFingerprintClientCallback_2_2 =
+        ::android::hardware::biometrics::fingerprint::V2_2::IBiometricsFingerprintClientCallback;
+using FingerprintAcquiredInfo_2_2 =
+        ::android::hardware::biometrics::fingerprint::V2_2::FingerprintAcquiredInfo;
 using ::android::hardware::biometrics::fingerprint::V2_1::RequestStatus;
 using ::android::hardware::Return;
 using ::android::hardware::Void;
 using ::android::hardware::hidl_vec;
 using ::android::hardware::hidl_string;
+using ::android::hardware::hidl_handle;
 using ::android::sp;
 
-struct BiometricsFingerprint : public IBiometricsFingerprint {
+/*
+ * A legacy HAL message, already translated to HIDL values, as it travels
+ * from the vendor library thread to the callback dispatcher.
+ */
+struct FingerprintEvent {
+    fingerprint_msg_type_t type;
+    int32_t info;
+    int32_t vendorCode;
+    uint32_t fid;
+    uint32_t gid;
+    uint32_t remaining;
+    hw_auth_token_t hat;
+    int64_t timestampNs;
+};
+
+struct BiometricsFingerprint : public IBiometricsFingerprint_2_3 {
 public:
     BiometricsFingerprint();
     ~BiometricsFingerprint();
 
     // Method to wrap legacy HAL with BiometricsFingerprint class
-    static IBiometricsFingerprint* getInstance();
+    static IBiometricsFingerprint_2_3* getInstance();
 
     // Methods from ::android::hardware::biometrics::fingerprint::V2_1::IBiometricsFingerprint follow.
     Return<uint64_t> setNotify(const sp<IBiometricsFingerprintClientCallback>& clientCallback) override;
@@ -61,18 +93,54 @@ public:
     Return<RequestStatus> setActiveGroup(uint32_t gid, const hidl_string& storePath) override;
     Return<RequestStatus> authenticate(uint64_t operationId, uint32_t gid) override;
 
+    // Methods from ::android::hardware::biometrics::fingerprint::V2_3::IBiometricsFingerprint follow.
+    Return<bool> isUdfps(uint32_t sensorId) override;
+    Return<void> onFingerDown(uint32_t x, uint32_t y, float minor, float major) override;
+    Return<void> onFingerUp() override;
+
+    // Methods from ::android::hidl::base::V1_0::IBase follow.
+    Return<void> debug(const hidl_handle& handle, const hidl_vec<hidl_string>& args) override;
+
 private:
     static fingerprint_device_t* openHal(std::string hal);
+    void probeHals(FpHal skip);
     static void notify(const fingerprint_msg_t *msg); /* Static callback for legacy HAL implementation */
     static Return<RequestStatus> ErrorFilter(int32_t error);
     static FingerprintError VendorErrorFilter(int32_t error, int32_t* vendorCode);
     static FingerprintAcquiredInfo VendorAcquiredFilter(int32_t error, int32_t* vendorCode);
+    static int32_t GoodixAcquiredFilter(int32_t info, int32_t* vendorCode);
     static BiometricsFingerprint* sInstance;
 
+    void queueEvent(const FingerprintEvent& event);
+    void dispatchLoop();
+    void dispatch(const FingerprintEvent& event);
+
+    BoundedQueue<FingerprintEvent, 64> mEvents;
+    ::android::base::unique_fd mEventFd;
+    std::atomic<bool> mDispatcherStop;
+    std::thread mDispatcher;
+    AuthTokenBuffer mAuthToken;
+
+    std::atomic<uint64_t> mDroppedAcquired;
+    std::atomic<uint64_t> mQueueFullStalls;
+    std::atomic<uint64_t> mMaxQueueDepth;
+    std::atomic<uint64_t> mAuthCount;
+    std::atomic<int64_t> mAuthLatencyLastNs;
+    std::atomic<int64_t> mAuthLatencyTotalNs;
+    std::atomic<int64_t> mAuthLatencyMaxNs;
+
+    // Capture state shared between binder calls and notify().
+    bool mUdfps;
+    std::atomic<bool> mCapturing;
+    std::atomic<uint64_t> mFingerDowns;
+    std::atomic<uint64_t> mFingerDownsIdle;
+
     std::mutex mClientCallbackMutex;
     sp<IBiometricsFingerprintClientCallback> mClientCallback;
+    sp<IBiometricsFingerprintClientCallback_2_2> mClientCallback_2_2;
     fingerprint_device_t *mDevice;
     FpHal currentHal;
+    std::unique_ptr<GoodixExtBridge> mGoodixExt;
 };
 
 }  // namespace implementation
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_BOUNDEDQUEUE_H
+#define ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_BOUNDEDQUEUE_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+
+/*
+ * Fixed-capacity lock-free queue for trivially copyable elements.
+ *
+ * Every slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled for the current lap, so push() and pop()
+ * only ever contend on a single compare-and-swap of the tail or head.
+ */
+template <typename T, size_t N>
+class BoundedQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "capacity must be a power of two");
+
+  public:
+    BoundedQueue() : mHead(0), mTail(0) {
+        for (size_t i = 0; i < N; i++) {
+            mCells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T& value) {
+        size_t pos = mTail.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = mCells[pos & (N - 1)];
+            intptr_t diff = intptr_t(cell.seq.load(std::memory_order_acquire)) - intptr_t(pos);
+
+            if (diff == 0) {
+                if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.data = value;
+                    cell.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mTail.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T* value) {
+        size_t pos = mHead.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = mCells[pos & (N - 1)];
+            intptr_t diff =
+                    intptr_t(cell.seq.load(std::memory_order_acquire)) - intptr_t(pos + 1);
+
+            if (diff == 0) {
+                if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    *value = cell.data;
+                    cell.seq.store(pos + N, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = mHead.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /* Approximate while producers or consumers are running. */
+    size_t size() const {
+        size_t tail = mTail.load(std::memory_order_relaxed);
+        size_t head = mHead.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+  private:
+    struct Cell {
+        std::atomic<size_t> seq;
+        T data;
+    };
+
+    std::array<Cell, N> mCells;
+    alignas(64) std::atomic<size_t> mHead;
+    alignas(64) std::atomic<size_t> mTail;
+};
+
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_BOUNDEDQUEUE_H
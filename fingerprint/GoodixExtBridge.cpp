@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "android.hardware.biometrics.fingerprint@2.1-service.mt6768"
+
+#include "GoodixExtBridge.h"
+
+#include <android-base/properties.h>
+#include <log/log.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+namespace V2_1 {
+namespace implementation {
+
+// Published by the lights HAL whenever the backlight turns on or off
+static const char* const kBacklightOnProp = "vendor.light.backlight_on";
+
+GoodixExtBridge::GoodixExtBridge()
+    : mState(std::make_shared<State>([] { return IGoodixFingerprintDaemonExt::tryGetService(); })) {
+    // The watcher blocks on the property until the next transition, so it
+    // can't be joined. It owns a reference to the state and notices stop
+    // the next time it wakes up.
+    std::thread(&GoodixExtBridge::watchLoop, mState).detach();
+}
+
+GoodixExtBridge::GoodixExtBridge(DaemonLookup lookup)
+    : mState(std::make_shared<State>(std::move(lookup))) {}
+
+GoodixExtBridge::~GoodixExtBridge() {
+    mState->stop = true;
+}
+
+void GoodixExtBridge::setScreen(bool on) {
+    forward(*mState, on);
+}
+
+void GoodixExtBridge::watchLoop(std::shared_ptr<State> state) {
+    std::string value = android::base::GetProperty(kBacklightOnProp, "");
+
+    while (!state->stop) {
+        std::string next = value == "1" ? "0" : "1";
+        if (!android::base::WaitForProperty(kBacklightOnProp, next)) {
+            continue;
+        }
+        if (state->stop) {
+            return;
+        }
+        value = next;
+        forward(*state, value == "1");
+    }
+}
+
+void GoodixExtBridge::forward(State& state, bool on) {
+    if (state.daemon == nullptr) {
+        state.daemon = state.lookup();
+        if (state.daemon == nullptr) {
+            if (!state.missing) {
+                ALOGW("Goodix daemon extension is not available, not forwarding screen state");
+                state.missing = true;
+            }
+            return;
+        }
+        state.missing = false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Return<uint32_t> ret = on ? state.daemon->screenOn() : state.daemon->screenOff();
+    int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    if (!ret.isOk()) {
+        ALOGE("Failed to forward screen state to Goodix daemon: %s", ret.description().c_str());
+        state.daemon = nullptr;
+        state.failures++;
+        return;
+    }
+    if (ret != 0) {
+        ALOGW("Goodix daemon rejected screen %s: %u", on ? "on" : "off", static_cast<uint32_t>(ret));
+        state.failures++;
+        return;
+    }
+
+    if (on) {
+        state.wakes++;
+        state.lastWakeNs = elapsed;
+        if (elapsed > state.maxWakeNs) {
+            state.maxWakeNs = elapsed;
+        }
+    } else {
+        state.sleeps++;
+    }
+}
+
+void GoodixExtBridge::dump(int fd) {
+    dprintf(fd, "Goodix screen on: count=%" PRIu64 " last=%" PRId64 "us max=%" PRId64 "us\n",
+            mState->wakes.load(), mState->lastWakeNs.load() / 1000,
+            mState->maxWakeNs.load() / 1000);
+    dprintf(fd, "Goodix screen off: count=%" PRIu64 " failures=%" PRIu64 "\n",
+            mState->sleeps.load(), mState->failures.load());
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
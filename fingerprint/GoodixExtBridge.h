@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_GOODIXEXTBRIDGE_H
+#define ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_GOODIXEXTBRIDGE_H
+
+#include <vendor/goodix/hardware/biometrics/fingerprint/2.1/IGoodixFingerprintDaemonExt.h>
+
+#include <atomic>
+#include <functional>
+#include <memory>
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+namespace V2_1 {
+namespace implementation {
+
+using ::vendor::goodix::hardware::biometrics::fingerprint::V2_1::IGoodixFingerprintDaemonExt;
+
+/*
+ * Forwards panel on/off transitions to the Goodix daemon extension, so the
+ * sensor is already powered by the time the first finger lands on it.
+ *
+ * The daemon is looked up on first use and dropped again on any transport
+ * error, a module without the extension simply never gets the commands.
+ */
+class GoodixExtBridge {
+  public:
+    using DaemonLookup = std::function<sp<IGoodixFingerprintDaemonExt>()>;
+
+    /* Follows the backlight and talks to the registered daemon extension. */
+    GoodixExtBridge();
+    /* Leaves screen transitions to setScreen(), for tests with a mock daemon. */
+    explicit GoodixExtBridge(DaemonLookup lookup);
+    ~GoodixExtBridge();
+
+    void setScreen(bool on);
+    void dump(int fd);
+
+  private:
+    struct State {
+        explicit State(DaemonLookup lookup) : lookup(std::move(lookup)) {}
+
+        const DaemonLookup lookup;
+
+        /* Only touched by whoever forwards transitions. */
+        sp<IGoodixFingerprintDaemonExt> daemon;
+        bool missing = false;
+
+        std::atomic<bool> stop{false};
+
+        std::atomic<uint64_t> wakes{0};
+        std::atomic<uint64_t> sleeps{0};
+        std::atomic<uint64_t> failures{0};
+        std::atomic<int64_t> lastWakeNs{0};
+        std::atomic<int64_t> maxWakeNs{0};
+    };
+
+    static void watchLoop(std::shared_ptr<State> state);
+    static void forward(State& state, bool on);
+
+    std::shared_ptr<State> mState;
+};
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
+
+#endif  // ANDROID_HARDWARE_BIOMETRICS_FINGERPRINT_GOODIXEXTBRIDGE_H
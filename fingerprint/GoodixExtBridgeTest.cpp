@@ -0,0 +1,150 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "GoodixExtBridge.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace android {
+namespace hardware {
+namespace biometrics {
+namespace fingerprint {
+namespace V2_1 {
+namespace implementation {
+
+using ::android::hardware::hidl_vec;
+using ::android::hardware::Return;
+using ::android::hardware::Status;
+using ::android::hardware::Void;
+using ::vendor::goodix::hardware::biometrics::fingerprint::V2_1::IGoodixFingerprintDaemonExtCallback;
+
+// Stands in for the Goodix daemon, only the screen commands do anything
+class MockGoodixDaemonExt : public IGoodixFingerprintDaemonExt {
+  public:
+    int screenOns = 0;
+    int screenOffs = 0;
+    uint32_t result = 0;
+    bool transportError = false;
+
+    Return<uint32_t> screenOn() override {
+        screenOns++;
+        return reply();
+    }
+    Return<uint32_t> screenOff() override {
+        screenOffs++;
+        return reply();
+    }
+
+    Return<void> initCallback(const sp<IGoodixFingerprintDaemonExtCallback>&) override {
+        return Void();
+    }
+    Return<uint32_t> cameraCapture() override { return 0; }
+    Return<uint32_t> dumpCmd(uint32_t, const hidl_vec<uint8_t>&) override { return 0; }
+    Return<uint32_t> enableFfFeature(uint8_t) override { return 0; }
+    Return<uint32_t> enableFingerprintModule(uint8_t) override { return 0; }
+    Return<uint32_t> enumerate() override { return 0; }
+    Return<uint32_t> lockout() override { return 0; }
+    Return<uint32_t> navigate(uint32_t) override { return 0; }
+    Return<uint32_t> pauseEnroll() override { return 0; }
+    Return<uint32_t> reset_lockout() override { return 0; }
+    Return<uint32_t> resumeEnroll() override { return 0; }
+    Return<uint32_t> setSafeClass(uint32_t) override { return 0; }
+    Return<uint32_t> stopCameraCapture() override { return 0; }
+    Return<uint32_t> stopNavigation() override { return 0; }
+
+  private:
+    Return<uint32_t> reply() {
+        if (transportError) {
+            return Status::fromExceptionCode(Status::EX_TRANSACTION_FAILED);
+        }
+        return result;
+    }
+};
+
+class GoodixExtBridgeTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mDaemon = new MockGoodixDaemonExt();
+        mBridge = std::make_unique<GoodixExtBridge>([this] {
+            mLookups++;
+            return mRegistered ? mDaemon : nullptr;
+        });
+    }
+
+    std::string dump() {
+        TemporaryFile file;
+        std::string out;
+
+        mBridge->dump(file.fd);
+        android::base::ReadFileToString(file.path, &out);
+        return out;
+    }
+
+    sp<MockGoodixDaemonExt> mDaemon;
+    std::unique_ptr<GoodixExtBridge> mBridge;
+    bool mRegistered = true;
+    int mLookups = 0;
+};
+
+TEST_F(GoodixExtBridgeTest, ForwardsScreenTransitions) {
+    mBridge->setScreen(true);
+    mBridge->setScreen(false);
+    mBridge->setScreen(true);
+
+    EXPECT_EQ(mDaemon->screenOns, 2);
+    EXPECT_EQ(mDaemon->screenOffs, 1);
+    // The daemon is kept between transitions
+    EXPECT_EQ(mLookups, 1);
+    EXPECT_NE(dump().find("Goodix screen on: count=2"), std::string::npos);
+}
+
+TEST_F(GoodixExtBridgeTest, MissingDaemonIsLookedUpAgain) {
+    mRegistered = false;
+    mBridge->setScreen(true);
+    mBridge->setScreen(false);
+
+    EXPECT_EQ(mLookups, 2);
+    EXPECT_EQ(mDaemon->screenOns, 0);
+
+    mRegistered = true;
+    mBridge->setScreen(true);
+
+    EXPECT_EQ(mDaemon->screenOns, 1);
+    EXPECT_NE(dump().find("failures=0"), std::string::npos);
+}
+
+TEST_F(GoodixExtBridgeTest, TransportErrorDropsDaemon) {
+    mDaemon->transportError = true;
+    mBridge->setScreen(true);
+
+    mDaemon->transportError = false;
+    mBridge->setScreen(false);
+
+    EXPECT_EQ(mLookups, 2);
+    EXPECT_EQ(mDaemon->screenOffs, 1);
+    EXPECT_NE(dump().find("failures=1"), std::string::npos);
+}
+
+TEST_F(GoodixExtBridgeTest, RejectedCommandKeepsDaemon) {
+    mDaemon->result = 1;
+    mBridge->setScreen(true);
+    mBridge->setScreen(true);
+
+    EXPECT_EQ(mLookups, 1);
+    EXPECT_EQ(mDaemon->screenOns, 2);
+    EXPECT_NE(dump().find("Goodix screen on: count=0"), std::string::npos);
+    EXPECT_NE(dump().find("failures=2"), std::string::npos);
+}
+
+}  // namespace implementation
+}  // namespace V2_1
+}  // namespace fingerprint
+}  // namespace biometrics
+}  // namespace hardware
+}  // namespace android
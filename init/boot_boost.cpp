@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "boot_boost.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+
+#include <ctime>
+#include <iterator>
+#include <unistd.h>
+
+#define CPU_CTRL  "/proc/perfmgr/boost_ctrl/cpu_ctrl/"
+#define EAS_CTRL  "/proc/perfmgr/boost_ctrl/eas_ctrl/"
+#define DVFSRC    "/sys/devices/platform/10012000.dvfsrc/helio-dvfsrc/"
+
+namespace {
+
+constexpr const char *kStageNames[] = {
+    "init",
+    "post-fs",
+    "post-fs-data",
+    "boot_completed",
+};
+
+static_assert(std::size(kStageNames) == size_t(BootStage::COUNT), "missing stage name");
+
+/*
+ * Everything raised to speed up boot, in the order it is applied. Nodes are
+ * restored in reverse order once sys.boot_completed is set.
+ */
+constexpr BootBoostWrite kBootBoost[] = {
+    /* Cluster and DRAM floors at the highest OPP */
+    {BootStage::INIT, CPU_CTRL "boot_freq", "0 0 0 0", "-1 -1 -1 -1"},
+    {BootStage::INIT, DVFSRC "dvfsrc_req_ddr_opp", "0", "-1"},
+
+    /* Schedtune boost for every group */
+    {BootStage::POST_FS, EAS_CTRL "boot_boost", "0 100", "0 0"},
+    {BootStage::POST_FS, EAS_CTRL "boot_boost", "1 100", "1 0"},
+    {BootStage::POST_FS, EAS_CTRL "boot_boost", "2 100", "2 0"},
+    {BootStage::POST_FS, EAS_CTRL "boot_boost", "3 100", "3 0"},
+    {BootStage::POST_FS, EAS_CTRL "sched_stune_task_thresh", "0", "-1"},
+
+    /* Read-ahead and request depth while the package manager scans */
+    {BootStage::POST_FS_DATA, "/sys/block/mmcblk0/queue/iostats", "0", "1"},
+    {BootStage::POST_FS_DATA, "/sys/block/mmcblk0/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/mmcblk0/queue/nr_requests", "256", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/sdc/queue/iostats", "0", "1"},
+    {BootStage::POST_FS_DATA, "/sys/block/sdc/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/sdc/queue/nr_requests", "256", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-0/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-1/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-2/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-3/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-4/queue/read_ahead_kb", "2048", "128"},
+    {BootStage::POST_FS_DATA, "/sys/block/dm-5/queue/read_ahead_kb", "2048", "128"},
+};
+
+static void write_node(const char *path, const char *value, BootBoostResult *result)
+{
+    /*
+     * Only one of mmcblk0 and sdc exists and the number of dm devices
+     * depends on the build, so missing nodes are expected.
+     */
+    if (access(path, F_OK) != 0) {
+        return;
+    }
+
+    if (android::base::WriteStringToFile(value, path)) {
+        result->written++;
+    } else {
+        PLOG(WARNING) << "boot_boost: failed to write " << value << " to " << path;
+        result->failed++;
+    }
+}
+
+}  // anonymous namespace
+
+const char *boot_stage_name(BootStage stage)
+{
+    return stage < BootStage::COUNT ? kStageNames[size_t(stage)] : "unknown";
+}
+
+bool boot_stage_from_name(const std::string &name, BootStage *stage)
+{
+    for (size_t i = 0; i < std::size(kStageNames); i++) {
+        if (name == kStageNames[i]) {
+            *stage = BootStage(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+uint64_t boot_boost_now_ms()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    return uint64_t(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+BootBoostResult boot_boost_apply(BootStage stage)
+{
+    BootBoostResult result = {};
+
+    for (const auto &entry : kBootBoost) {
+        if (entry.stage == stage) {
+            write_node(entry.path, entry.value, &result);
+        }
+    }
+
+    return result;
+}
+
+BootBoostResult boot_boost_restore()
+{
+    BootBoostResult result = {};
+
+    for (auto it = std::rbegin(kBootBoost); it != std::rend(kBootBoost); ++it) {
+        if (it->stage < BootStage::BOOT_COMPLETED && it->restore != nullptr) {
+            write_node(it->path, it->restore, &result);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#define BOOT_BOOST_PROP_PREFIX "vendor.boot_boost."
+#define BOOT_BOOST_STAGE_PROP  BOOT_BOOST_PROP_PREFIX "stage"
+
+/*
+ * Boot stages the boost table is keyed on, in the order init reaches them.
+ * INIT is applied by the init extension itself, the later ones by the
+ * boot_boost service once init.rc announces them.
+ */
+enum class BootStage {
+    INIT,
+    POST_FS,
+    POST_FS_DATA,
+    BOOT_COMPLETED,
+    COUNT,
+};
+
+struct BootBoostWrite {
+    BootStage stage;
+    const char *path;
+    const char *value;
+    /* Written back at boot_completed, nullptr leaves the node as is. */
+    const char *restore;
+};
+
+struct BootBoostResult {
+    int written;
+    int failed;
+};
+
+const char *boot_stage_name(BootStage stage);
+bool boot_stage_from_name(const std::string &name, BootStage *stage);
+
+/* Milliseconds since boot, suspend included. */
+uint64_t boot_boost_now_ms();
+
+/* Write every node of the given stage. */
+BootBoostResult boot_boost_apply(BootStage stage);
+
+/* Write back the restore value of every node raised before boot_completed. */
+BootBoostResult boot_boost_restore();
@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "boot_boost.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+
+#include <array>
+#include <cstdio>
+#include <cstdlib>
+
+#define REPORT_DIR  "/data/vendor/boot_boost"
+#define REPORT_FILE REPORT_DIR "/report"
+
+using android::base::GetProperty;
+using android::base::SetProperty;
+using android::base::StringAppendF;
+using android::base::WaitForProperty;
+
+namespace {
+
+struct StageRecord {
+    bool reached;
+    uint64_t ms;
+    BootBoostResult result;
+};
+
+std::array<StageRecord, size_t(BootStage::COUNT)> records;
+
+std::string stamp_prop(BootStage stage)
+{
+    return std::string(BOOT_BOOST_PROP_PREFIX) + boot_stage_name(stage) + "_ms";
+}
+
+void record_stage(BootStage stage, const BootBoostResult &result)
+{
+    StageRecord &record = records[size_t(stage)];
+
+    record = {true, boot_boost_now_ms(), result};
+    SetProperty(stamp_prop(stage), std::to_string(record.ms));
+
+    LOG(INFO) << boot_stage_name(stage) << " at " << record.ms << "ms, " << result.written
+              << " nodes written, " << result.failed << " failed";
+}
+
+void apply_stage(BootStage stage)
+{
+    record_stage(stage, boot_boost_apply(stage));
+}
+
+/*
+ * The init extension has no way to report back, it leaves the time it
+ * raised the INIT floors and how many nodes it wrote in properties instead.
+ */
+void load_init_stage()
+{
+    StageRecord &record = records[size_t(BootStage::INIT)];
+    std::string ms = GetProperty(stamp_prop(BootStage::INIT), "");
+
+    if (!ms.empty()) {
+        record.reached = true;
+        record.ms = strtoull(ms.c_str(), nullptr, 10);
+        record.result.written = atoi(GetProperty(BOOT_BOOST_PROP_PREFIX "init_written", "0").c_str());
+        record.result.failed = atoi(GetProperty(BOOT_BOOST_PROP_PREFIX "init_failed", "0").c_str());
+    }
+}
+
+void write_report()
+{
+    std::string report;
+    uint64_t previous = 0;
+
+    StringAppendF(&report, "%-16s %10s %10s %8s %7s\n", "stage", "at_ms", "delta_ms", "written",
+                  "failed");
+
+    for (size_t i = 0; i < records.size(); i++) {
+        const StageRecord &record = records[i];
+
+        if (!record.reached) {
+            StringAppendF(&report, "%-16s %10s\n", boot_stage_name(BootStage(i)), "-");
+            continue;
+        }
+
+        StringAppendF(&report, "%-16s %10llu %10llu %8d %7d\n", boot_stage_name(BootStage(i)),
+                      (unsigned long long)record.ms, (unsigned long long)(record.ms - previous),
+                      record.result.written, record.result.failed);
+        previous = record.ms;
+    }
+
+    const StageRecord &first = records[size_t(BootStage::INIT)];
+    const StageRecord &last = records[size_t(BootStage::BOOT_COMPLETED)];
+    if (first.reached) {
+        StringAppendF(&report, "boosted_ms %llu\n", (unsigned long long)(last.ms - first.ms));
+    }
+
+    LOG(INFO) << "boot report:\n" << report;
+
+    /* Keep the previous boot around so the two can be compared. */
+    rename(REPORT_FILE, REPORT_FILE ".1");
+    if (!android::base::WriteStringToFile(report, REPORT_FILE)) {
+        PLOG(ERROR) << "failed to write " << REPORT_FILE;
+    }
+}
+
+}  // anonymous namespace
+
+int main()
+{
+    load_init_stage();
+
+    /*
+     * init.rc announces each stage by setting the stage property, which may
+     * already be past the first one we handle if we were started late.
+     */
+    for (int next = int(BootStage::POST_FS); next < int(BootStage::BOOT_COMPLETED);) {
+        BootStage current;
+
+        if (!boot_stage_from_name(GetProperty(BOOT_BOOST_STAGE_PROP, ""), &current)) {
+            current = BootStage::INIT;
+        }
+
+        for (; next <= int(current) && next < int(BootStage::BOOT_COMPLETED); next++) {
+            apply_stage(BootStage(next));
+        }
+
+        if (next < int(BootStage::BOOT_COMPLETED)) {
+            WaitForProperty(BOOT_BOOST_STAGE_PROP, boot_stage_name(BootStage(next)));
+        }
+    }
+
+    WaitForProperty("sys.boot_completed", "1");
+
+    BootBoostResult result = boot_boost_restore();
+    BootBoostResult completed = boot_boost_apply(BootStage::BOOT_COMPLETED);
+
+    result.written += completed.written;
+    result.failed += completed.failed;
+    record_stage(BootStage::BOOT_COMPLETED, result);
+    write_report();
+
+    return 0;
+}
@@ -5,71 +5,135 @@
  */
 
 #include <cstring>
+#include <map>
+#include <string>
+#include <vector>
 #include <sys/sysinfo.h>
 
-#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
-#include <sys/_system_properties.h>
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/strings.h>
 
 #include "property_service.h"
+#include "util.h"
 
-void property_override(char const prop[], char const value[])
+#include "boot_boost.h"
+#include "property_override.h"
+#include "ram_tier.h"
+
+void load_ram_tier_properties()
 {
-    auto pi = (prop_info *) __system_property_find(prop);
+    struct sysinfo sys;
+    std::string conf;
+
+    sysinfo(&sys);
+
+    uint64_t total_mib = ram_total_mib(sys.totalram, sys.mem_unit);
+    const RamTier &tier = ram_tier_select(total_mib);
 
-    if (pi != nullptr) {
-        __system_property_update(pi, value, strlen(value));
-    } else {
-        __system_property_add(prop, strlen(prop), value, strlen(value));
+    /* The conf is optional, without it the table values are used as is. */
+    android::base::ReadFileToString(RAM_TIERS_CONF, &conf);
+
+    std::map<std::string, std::string> values = ram_tier_properties(tier, conf);
+
+    std::vector<PropertyOverride> props = {{"ro.vendor.ram_tier", tier.name}};
+    for (const auto &[name, value] : values) {
+        props.push_back({name.c_str(), value.c_str()});
     }
+
+    size_t written = property_override(props.data(), props.size());
+
+    LOG(INFO) << "ram tier " << tier.name << " for " << total_mib << " MiB, " << written
+              << " of " << props.size() << " properties written";
 }
 
-void load_dalvik_properties()
+struct DeviceVariant {
+    /* androidboot.hwname passed by the bootloader */
+    char const *hwname;
+    PropertyOverride const *props;
+    size_t count;
+};
+
+/*
+ * Properties applied on top of the common ones for each model. The models
+ * share a panel and their tuning, so none needs its own yet: give one a
+ * constexpr PropertyOverride table and point its entry at it.
+ */
+static constexpr DeviceVariant variants[] = {
+    {"merlin", nullptr, 0},
+    {"merlinnfc", nullptr, 0},
+    {"lancelot", nullptr, 0},
+    {"galahad", nullptr, 0},
+    {"shiva", nullptr, 0},
+};
+
+/*
+ * The bootloader normally shows up as ro.boot.hwname, fall back to the
+ * command line in case it was passed in a form init didn't export.
+ */
+static std::string get_hwname()
 {
-    char const *heapstartsize;
-    char const *heapgrowthlimit;
-    char const *heapsize;
-    char const *heapminfree;
-    char const *heapmaxfree;
-    char const *heaptargetutilization;
-    struct sysinfo sys;
+    std::string hwname = android::base::GetProperty("ro.boot.hwname", "");
+    std::string cmdline;
 
-    sysinfo(&sys);
+    if (!hwname.empty() || !android::base::ReadFileToString("/proc/cmdline", &cmdline)) {
+        return hwname;
+    }
+
+    for (const auto &entry : android::base::Split(android::base::Trim(cmdline), " ")) {
+        if (android::base::StartsWith(entry, "androidboot.hwname=")) {
+            return entry.substr(strlen("androidboot.hwname="));
+        }
+    }
+
+    return hwname;
+}
+
+void load_variant_properties()
+{
+    std::string hwname = get_hwname();
+
+    for (const auto &variant : variants) {
+        if (hwname == variant.hwname) {
+            size_t written = property_override(variant.props, variant.count);
 
-    if (sys.totalram >= 5ull * 1024 * 1024 * 1024) {
-        // from - phone-xhdpi-6144-dalvik-heap.mk
-        heapstartsize = "16m";
-        heapgrowthlimit = "256m";
-        heapsize = "512m";
-        heaptargetutilization = "0.5";
-        heapminfree = "8m";
-        heapmaxfree = "32m";
-    } else if (sys.totalram >= 3ull * 1024 * 1024 * 1024) {
-        // from - phone-xhdpi-4096-dalvik-heap.mk
-        heapstartsize = "8m";
-        heapgrowthlimit = "192m";
-        heapsize = "512m";
-        heaptargetutilization = "0.6";
-        heapminfree = "8m";
-        heapmaxfree = "16m";
-    } else {
-        // from - phone-xhdpi-2048-dalvik-heap.mk
-        heapstartsize = "8m";
-        heapgrowthlimit = "192m";
-        heapsize = "512m";
-        heaptargetutilization = "0.75";
-        heapminfree = "512k";
-        heapmaxfree = "8m";
+            LOG(INFO) << "variant " << hwname << ", " << written << " of " << variant.count
+                      << " properties written";
+            return;
+        }
     }
 
-    property_override("dalvik.vm.heapstartsize", heapstartsize);
-    property_override("dalvik.vm.heapgrowthlimit", heapgrowthlimit);
-    property_override("dalvik.vm.heapsize", heapsize);
-    property_override("dalvik.vm.heaptargetutilization", heaptargetutilization);
-    property_override("dalvik.vm.heapminfree", heapminfree);
-    property_override("dalvik.vm.heapmaxfree", heapmaxfree);
+    LOG(WARNING) << "unknown variant '" << hwname << "', using common properties";
+}
+
+void load_boot_boost()
+{
+    /* Nothing restores the floors in recovery, leave the defaults there. */
+    if (android::init::IsRecoveryMode()) {
+        return;
+    }
+
+    BootBoostResult result = boot_boost_apply(BootStage::INIT);
+    std::string ms = std::to_string(boot_boost_now_ms());
+
+    LOG(INFO) << "boot_boost: init at " << ms << "ms, " << result.written << " nodes written, "
+              << result.failed << " failed";
+
+    std::string written = std::to_string(result.written);
+    std::string failed = std::to_string(result.failed);
+
+    /* Picked up by the boot_boost service for its report. */
+    property_override({
+        {BOOT_BOOST_PROP_PREFIX "init_ms", ms.c_str()},
+        {BOOT_BOOST_PROP_PREFIX "init_written", written.c_str()},
+        {BOOT_BOOST_PROP_PREFIX "init_failed", failed.c_str()},
+    });
 }
 
 void vendor_load_properties()
 {
-    load_dalvik_properties();
+    load_boot_boost();
+    load_ram_tier_properties();
+    load_variant_properties();
 }
@@ -0,0 +1,24 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The slice of bionic's property area API property_override() uses, so it
+ * can be built against a stand-in on the host.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#define PROP_VALUE_MAX 92
+
+struct prop_info;
+
+const prop_info *__system_property_find(const char *name);
+int __system_property_read(const prop_info *pi, char *name, char *value);
+int __system_property_update(prop_info *pi, const char *value, unsigned int len);
+int __system_property_add(const char *name, unsigned int namelen, const char *value,
+                          unsigned int valuelen);
@@ -0,0 +1,46 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "property_override.h"
+
+#include <cstdint>
+#include <cstring>
+
+#define _REALLY_INCLUDE_SYS__SYSTEM_PROPERTIES_H_
+#include <sys/_system_properties.h>
+
+size_t property_override(PropertyOverride const props[], size_t count)
+{
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        char const *prop = props[i].name;
+        char const *value = props[i].value;
+        auto pi = (prop_info *) __system_property_find(prop);
+
+        if (pi != nullptr) {
+            char current[PROP_VALUE_MAX];
+
+            if (__system_property_read(pi, nullptr, current) >= 0 &&
+                strcmp(current, value) == 0) {
+                continue;
+            }
+            __system_property_update(pi, value, strlen(value));
+        } else {
+            __system_property_add(prop, strlen(prop), value, strlen(value));
+        }
+        written++;
+    }
+
+    return written;
+}
+
+void property_override(char const prop[], char const value[])
+{
+    PropertyOverride override = {prop, value};
+
+    property_override(&override, 1);
+}
@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstddef>
+
+struct PropertyOverride {
+    char const *name;
+    char const *value;
+};
+
+/*
+ * Apply a batch of overrides, looking each property up once. Properties
+ * that already hold the value are left alone, so their serial doesn't move
+ * and nothing waiting on them is woken up. Properties that change cost a
+ * read more than writing them blindly would. Returns how many were written.
+ */
+size_t property_override(PropertyOverride const props[], size_t count);
+
+template <size_t N>
+size_t property_override(PropertyOverride const (&props)[N])
+{
+    return property_override(props, N);
+}
+
+void property_override(char const prop[], char const value[]);
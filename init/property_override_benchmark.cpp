@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "property_override.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <sys/_system_properties.h>
+
+/*
+ * Stand-in for the property area: a hash lookup per find, and a serial bump
+ * plus futex wake per write, like bionic does for waiters.
+ */
+struct prop_info {
+    std::string value;
+    uint32_t serial;
+};
+
+namespace {
+
+std::unordered_map<std::string, prop_info> area;
+size_t writes;
+
+void property_write(prop_info *pi, const char *value, unsigned int len)
+{
+    pi->value.assign(value, len);
+    pi->serial += 2;
+    syscall(SYS_futex, &pi->serial, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    writes++;
+}
+
+}  // anonymous namespace
+
+const prop_info *__system_property_find(const char *name)
+{
+    auto it = area.find(name);
+
+    return it != area.end() ? &it->second : nullptr;
+}
+
+int __system_property_read(const prop_info *pi, char *name, char *value)
+{
+    size_t len = std::min(pi->value.size(), size_t(PROP_VALUE_MAX - 1));
+
+    if (name != nullptr) {
+        name[0] = '\0';
+    }
+    memcpy(value, pi->value.c_str(), len);
+    value[len] = '\0';
+    return int(len);
+}
+
+int __system_property_update(prop_info *pi, const char *value, unsigned int len)
+{
+    property_write(pi, value, len);
+    return 0;
+}
+
+int __system_property_add(const char *name, unsigned int namelen, const char *value,
+                          unsigned int valuelen)
+{
+    property_write(&area[std::string(name, namelen)], value, valuelen);
+    return 0;
+}
+
+namespace {
+
+/* What the init extension sets during early init, RAM tier and boot_boost stamps. */
+constexpr PropertyOverride kProps[] = {
+    {"ro.vendor.ram_tier", "4g"},
+    {"dalvik.vm.heapstartsize", "8m"},
+    {"dalvik.vm.heapgrowthlimit", "192m"},
+    {"dalvik.vm.heapsize", "512m"},
+    {"dalvik.vm.heaptargetutilization", "0.6"},
+    {"dalvik.vm.heapminfree", "8m"},
+    {"dalvik.vm.heapmaxfree", "16m"},
+    {"ro.lmk.swap_free_low_percentage", "10"},
+    {"ro.lmk.thrashing_limit", "10"},
+    {"ro.lmk.psi_partial_stall_ms", "35"},
+    {"ro.vendor.zram.size_percent", "50"},
+    {"ro.vendor.variant", "merlin"},
+    {"vendor.boot_boost.init_ms", "1843"},
+    {"vendor.boot_boost.init_written", "14"},
+    {"vendor.boot_boost.init_failed", "0"},
+    {"vendor.boot_boost.stage", "init"},
+};
+
+constexpr PropertyOverride kChangedProps[] = {
+    {"ro.vendor.ram_tier", "6g"},
+    {"dalvik.vm.heapstartsize", "16m"},
+    {"dalvik.vm.heapgrowthlimit", "256m"},
+    {"dalvik.vm.heapsize", "1g"},
+    {"dalvik.vm.heaptargetutilization", "0.5"},
+    {"dalvik.vm.heapminfree", "4m"},
+    {"dalvik.vm.heapmaxfree", "32m"},
+    {"ro.lmk.swap_free_low_percentage", "15"},
+    {"ro.lmk.thrashing_limit", "20"},
+    {"ro.lmk.psi_partial_stall_ms", "50"},
+    {"ro.vendor.zram.size_percent", "75"},
+    {"ro.vendor.variant", "lancelot"},
+    {"vendor.boot_boost.init_ms", "1902"},
+    {"vendor.boot_boost.init_written", "13"},
+    {"vendor.boot_boost.init_failed", "1"},
+    {"vendor.boot_boost.stage", "post-fs"},
+};
+
+static_assert(std::size(kProps) == std::size(kChangedProps), "tables differ in size");
+
+/*
+ * Fill the area with about as many properties as early init has set by now,
+ * plus the table itself, as on any pass after the first.
+ */
+void reset_area()
+{
+    area.clear();
+    for (int i = 0; i < 200; i++) {
+        std::string name = "ro.boot.stand_in." + std::to_string(i);
+
+        property_write(&area[name], "1", 1);
+    }
+    property_override(kProps);
+    writes = 0;
+}
+
+/* The override before batching: look up and write every property. */
+void property_override_each(PropertyOverride const props[], size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        char const *prop = props[i].name;
+        char const *value = props[i].value;
+        auto pi = (prop_info *) __system_property_find(prop);
+
+        if (pi != nullptr) {
+            __system_property_update(pi, value, strlen(value));
+        } else {
+            __system_property_add(prop, strlen(prop), value, strlen(value));
+        }
+    }
+}
+
+void BM_OverrideEach(benchmark::State &state)
+{
+    reset_area();
+
+    for (auto _ : state) {
+        property_override_each(kProps, std::size(kProps));
+    }
+
+    state.counters["writes/pass"] = benchmark::Counter(writes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OverrideEach);
+
+void BM_OverrideBatchUnchanged(benchmark::State &state)
+{
+    reset_area();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(property_override(kProps));
+    }
+
+    state.counters["writes/pass"] = benchmark::Counter(writes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OverrideBatchUnchanged);
+
+void BM_OverrideBatchChanged(benchmark::State &state)
+{
+    bool flip = false;
+
+    reset_area();
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(property_override(flip ? kProps : kChangedProps));
+        flip = !flip;
+    }
+
+    state.counters["writes/pass"] = benchmark::Counter(writes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_OverrideBatchChanged);
+
+}  // anonymous namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ram_tier.h"
+
+#include <android-base/logging.h>
+#include <android-base/strings.h>
+
+#include <iterator>
+#include <vector>
+
+namespace {
+
+constexpr RamTier kRamTiers[] = {
+    // scaled up from phone-xhdpi-6144-dalvik-heap.mk
+    {"8g", 7168, "24m", "384m", "512m", "0.42", "8m", "56m", "10", "30", "70", "25"},
+    // from - phone-xhdpi-6144-dalvik-heap.mk
+    {"6g", 5120, "16m", "256m", "512m", "0.5", "8m", "32m", "10", "20", "50", "50"},
+    // from - phone-xhdpi-4096-dalvik-heap.mk
+    {"4g", 3072, "8m", "192m", "512m", "0.6", "8m", "16m", "10", "10", "35", "50"},
+    // from - phone-xhdpi-2048-dalvik-heap.mk, with the 3 GiB growth limit
+    {"3g", 2048, "8m", "192m", "512m", "0.75", "512k", "8m", "15", "10", "35", "75"},
+    // from - phone-xhdpi-2048-dalvik-heap.mk
+    {"2g", 0, "8m", "128m", "256m", "0.75", "512k", "8m", "20", "5", "35", "75"},
+};
+
+}  // anonymous namespace
+
+uint64_t ram_total_mib(uint64_t totalram, uint32_t mem_unit)
+{
+    return totalram * mem_unit / (1024 * 1024);
+}
+
+const RamTier &ram_tier_select(uint64_t total_mib)
+{
+    for (const auto &tier : kRamTiers) {
+        if (total_mib >= tier.min_mib) {
+            return tier;
+        }
+    }
+
+    return kRamTiers[std::size(kRamTiers) - 1];
+}
+
+std::map<std::string, std::string> ram_tier_properties(const RamTier &tier,
+                                                       const std::string &conf)
+{
+    std::map<std::string, std::string> props = {
+        {"dalvik.vm.heapstartsize", tier.heapstartsize},
+        {"dalvik.vm.heapgrowthlimit", tier.heapgrowthlimit},
+        {"dalvik.vm.heapsize", tier.heapsize},
+        {"dalvik.vm.heaptargetutilization", tier.heaptargetutilization},
+        {"dalvik.vm.heapminfree", tier.heapminfree},
+        {"dalvik.vm.heapmaxfree", tier.heapmaxfree},
+        {"ro.lmk.swap_free_low_percentage", tier.swap_free_low_percentage},
+        {"ro.lmk.thrashing_limit", tier.thrashing_limit},
+        {"ro.lmk.psi_partial_stall_ms", tier.psi_partial_stall_ms},
+        {"ro.vendor.zram.size_percent", tier.zram_percent},
+    };
+
+    for (const auto &raw_line : android::base::Split(conf, "\n")) {
+        std::string line = android::base::Trim(raw_line);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> fields = android::base::Split(line, " ");
+        if (fields.size() != 3) {
+            LOG(WARNING) << "ignoring malformed line in " << RAM_TIERS_CONF << ": " << line;
+            continue;
+        }
+
+        if (fields[0] == tier.name) {
+            props[fields[1]] = fields[2];
+        }
+    }
+
+    return props;
+}
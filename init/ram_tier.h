@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+
+#define RAM_TIERS_CONF "/vendor/etc/ram_tiers.conf"
+
+/*
+ * Per RAM tier heap, lmkd and zram settings, sorted by descending size. The
+ * first tier whose min_mib fits in totalram is used, totalram is a bit
+ * under the nominal size so each threshold sits below the next size down.
+ */
+struct RamTier {
+    char const *name;
+    uint64_t min_mib;
+    char const *heapstartsize;
+    char const *heapgrowthlimit;
+    char const *heapsize;
+    char const *heaptargetutilization;
+    char const *heapminfree;
+    char const *heapmaxfree;
+    char const *swap_free_low_percentage;
+    char const *thrashing_limit;
+    char const *psi_partial_stall_ms;
+    /* Picks /vendor/etc/fstab.zram.<percent> for swapon_all */
+    char const *zram_percent;
+};
+
+/* sysinfo's totalram, counted in mem_unit bytes, in MiB. */
+uint64_t ram_total_mib(uint64_t totalram, uint32_t mem_unit);
+
+const RamTier &ram_tier_select(uint64_t total_mib);
+
+/*
+ * Properties for the tier, with the lines of a ram_tiers.conf applied on
+ * top. Lines of "<tier> <property> <value>" replace or add a property for
+ * that tier, so a device can tune a tier without rebuilding the init
+ * extension.
+ */
+std::map<std::string, std::string> ram_tier_properties(const RamTier &tier,
+                                                       const std::string &conf);
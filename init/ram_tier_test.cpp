@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ram_tier.h"
+
+#include <gtest/gtest.h>
+
+namespace {
+
+constexpr uint64_t kMiB = 1024 * 1024;
+
+std::string tier_for(uint64_t total_mib)
+{
+    return ram_tier_select(total_mib).name;
+}
+
+TEST(RamTierTest, Boundaries)
+{
+    EXPECT_EQ(tier_for(16384), "8g");
+    EXPECT_EQ(tier_for(7168), "8g");
+    EXPECT_EQ(tier_for(7167), "6g");
+    EXPECT_EQ(tier_for(5120), "6g");
+    EXPECT_EQ(tier_for(5119), "4g");
+    EXPECT_EQ(tier_for(3072), "4g");
+    EXPECT_EQ(tier_for(3071), "3g");
+    EXPECT_EQ(tier_for(2048), "3g");
+    EXPECT_EQ(tier_for(2047), "2g");
+    EXPECT_EQ(tier_for(0), "2g");
+}
+
+TEST(RamTierTest, MemUnitScaling)
+{
+    EXPECT_EQ(ram_total_mib(3072 * kMiB, 1), 3072u);
+    EXPECT_EQ(ram_total_mib(3072 * kMiB / 4096, 4096), 3072u);
+    EXPECT_EQ(ram_total_mib(3072 * kMiB / 64, 64), 3072u);
+
+    /* A byte short of the boundary stays in the lower tier. */
+    EXPECT_EQ(tier_for(ram_total_mib(3072 * kMiB - 1, 1)), "3g");
+    EXPECT_EQ(tier_for(ram_total_mib(3072 * kMiB / 4096 - 1, 4096)), "3g");
+
+    /* 8 GiB in bytes doesn't fit 32 bits, the product must not wrap. */
+    EXPECT_EQ(ram_total_mib(8192 * kMiB / 4096, 4096), 8192u);
+    EXPECT_EQ(tier_for(ram_total_mib(8192 * kMiB / 4096, 4096)), "8g");
+}
+
+TEST(RamTierTest, TableValues)
+{
+    auto props = ram_tier_properties(ram_tier_select(2048), "");
+
+    EXPECT_EQ(props.size(), 10u);
+    EXPECT_EQ(props["dalvik.vm.heapgrowthlimit"], "192m");
+    EXPECT_EQ(props["ro.lmk.swap_free_low_percentage"], "15");
+    EXPECT_EQ(props["ro.vendor.zram.size_percent"], "75");
+}
+
+TEST(RamTierTest, ConfOverride)
+{
+    const std::string conf =
+            "# tuned for the 3 GiB models\n"
+            "\n"
+            "3g dalvik.vm.heapgrowthlimit 256m\n"
+            "  3g ro.lmk.kill_heaviest_task true  \n"
+            "4g dalvik.vm.heapgrowthlimit 384m\n";
+
+    auto props = ram_tier_properties(ram_tier_select(2048), conf);
+
+    EXPECT_EQ(props.size(), 11u);
+    EXPECT_EQ(props["dalvik.vm.heapgrowthlimit"], "256m");
+    EXPECT_EQ(props["ro.lmk.kill_heaviest_task"], "true");
+    EXPECT_EQ(props["dalvik.vm.heapsize"], "512m");
+}
+
+TEST(RamTierTest, ConfOtherTierIgnored)
+{
+    auto props = ram_tier_properties(ram_tier_select(5120), "3g dalvik.vm.heapsize 1g\n");
+
+    EXPECT_EQ(props["dalvik.vm.heapsize"], "512m");
+}
+
+TEST(RamTierTest, ConfMalformedLinesIgnored)
+{
+    const std::string conf =
+            "2g dalvik.vm.heapsize\n"
+            "2g dalvik.vm.heapsize 512m extra\n"
+            "2g dalvik.vm.heapminfree 1m\n";
+
+    auto props = ram_tier_properties(ram_tier_select(0), conf);
+
+    EXPECT_EQ(props["dalvik.vm.heapsize"], "256m");
+    EXPECT_EQ(props["dalvik.vm.heapminfree"], "1m");
+}
+
+}  // anonymous namespace
@@ -8,21 +8,104 @@
 
 #include <log/log.h>
 
-int perf_lock_acq(int hdl, int dur, long num, unsigned int tid) {
-    ALOGI("[%s] hdl: %d, dur: %d, num: %ld, tid: %u",
-            __func__, hdl, dur, num, tid);
-    if (hdl > 0)
-        return hdl;
+#include <mtkperf_client.h>
 
-    return 233;
+#include "perf_lock.h"
+#include "perf_res.h"
+#include "perf_trace.h"
+
+static void init_values(int values[PERF_NODE_COUNT]) {
+    int node;
+
+    for (node = 0; node < PERF_NODE_COUNT; node++)
+        values[node] = perf_res_table[node].unset;
+}
+
+/*
+ * list holds numArgs / 2 pairs of resource opcode and value. Each floor
+ * becomes the powerhint.json hint for that node and level, caps are only
+ * traced.
+ */
+int perf_lock_acq(int hdl, int dur, int list[], int numArgs) {
+    int values[PERF_NODE_COUNT];
+    uint64_t hints = 0;
+    int i, node, hint;
+
+    init_values(values);
+
+    for (i = 0; list != NULL && i + 1 < numArgs; i += 2) {
+        node = perf_res_lookup(list[i]);
+        if (node < 0) {
+            ALOGV("[%s] unsupported resource 0x%x", __func__, list[i]);
+            continue;
+        }
+        values[node] = list[i + 1];
+    }
+
+    /* A node named twice keeps the last value, as with MediaTek's client. */
+    for (node = 0; node < PERF_NODE_COUNT; node++) {
+        if (values[node] == perf_res_table[node].unset)
+            continue;
+
+        hint = perf_res_hint(node, values[node]);
+        if (hint >= 0)
+            hints |= 1ULL << hint;
+        else
+            ALOGV("[%s] %s is left to the Power HAL", __func__, perf_res_table[node].name);
+    }
+
+    hdl = perf_engine_acquire(hdl, dur, hints, NULL);
+    perf_trace_record(PERF_TRACE_ACQUIRE, hdl, dur, -1, values, __builtin_return_address(0));
+
+    return hdl;
+}
+
+/*
+ * Not part of the MediaTek API, whose perf_lock_acq has no way to name a
+ * thread. Boosts tid alone instead of raising floors for every CPU.
+ */
+int perf_thread_lock_acq(int hdl, int dur, int tid, int uclamp_min, int uclamp_max) {
+    struct thread_boost_req thread = { tid, uclamp_min, uclamp_max };
+
+    if (tid <= 0 || uclamp_min < 0 || uclamp_min > uclamp_max || uclamp_max > 1024) {
+        ALOGE("[%s] invalid thread boost %d %d..%d", __func__, tid, uclamp_min, uclamp_max);
+        return -1;
+    }
+
+    hdl = perf_engine_acquire(hdl, dur, 0, &thread);
+    perf_trace_record(PERF_TRACE_ACQUIRE, hdl, dur, -1, NULL, __builtin_return_address(0));
+
+    return hdl;
 }
 
 int perf_lock_rel(int hdl) {
-    ALOGI("[%s] hdl: %d", __func__, hdl);
-    return 0;
+    int ret = perf_engine_release(hdl);
+
+    if (ret == 0)
+        perf_trace_record(PERF_TRACE_RELEASE, hdl, 0, -1, NULL, __builtin_return_address(0));
+
+    return ret;
 }
 
+/* Customer hints carry no resource list, they all share MTKPERF_CUS_HINT. */
 int perf_cus_lock_hint(int hint, int dur) {
-    ALOGI("[%s], hint: %d, dur: %d", __func__, hint, dur);
-    return 233;
+    int hdl;
+
+    hdl = perf_engine_acquire(0, dur, 1ULL << PERF_HINT_CUS, NULL);
+    perf_trace_record(PERF_TRACE_HINT, hdl, dur, hint, NULL, __builtin_return_address(0));
+
+    return hdl;
+}
+
+/* Not part of the MediaTek API, for inspecting the engine from a debugger or test. */
+void perf_lock_dump(int fd) {
+    perf_engine_dump(fd);
+}
+
+/*
+ * Writes the binary event trace, see perf_trace_report.py. Live processes
+ * dump on their own when vendor.perf_trace.dump changes.
+ */
+int perf_lock_dump_trace(int fd) {
+    return perf_trace_dump(fd);
 }
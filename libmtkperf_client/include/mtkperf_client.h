@@ -0,0 +1,30 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* MediaTek perf lock API, list holds numArgs / 2 pairs of opcode and value. */
+int perf_lock_acq(int hdl, int dur, int list[], int numArgs);
+int perf_lock_rel(int hdl);
+int perf_cus_lock_hint(int hint, int dur);
+
+/*
+ * Clamps the utilization of tid alone to uclamp_min..uclamp_max (0..1024)
+ * for dur ms, or until released with perf_lock_rel if dur is 0. Passing
+ * back a live handle updates that lock. Returns the handle or -1.
+ */
+int perf_thread_lock_acq(int hdl, int dur, int tid, int uclamp_min, int uclamp_max);
+
+void perf_lock_dump(int fd);
+int perf_lock_dump_trace(int fd);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libmtkperf_client"
+
+#include "node_writer.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+struct node {
+    char path[PATH_MAX]; /* empty if the entry is free */
+    int fd;
+    bool write_failed;
+};
+
+static const char *node_root = "";
+
+/* Owned by the engine thread. */
+static struct node nodes[NODE_WRITER_MAX];
+
+static _Atomic uint64_t stat_writes;
+static _Atomic uint64_t stat_failed;
+static _Atomic uint64_t stat_opens;
+static _Atomic uint64_t stat_skipped;
+
+void node_writer_set_root(const char *root) {
+    node_root = root;
+}
+
+/* Returns the entry for path, recycling the oldest one when the table is full. */
+static struct node *find_node(const char *path) {
+    struct node *free_node = NULL;
+    int i;
+
+    for (i = 0; i < NODE_WRITER_MAX; i++) {
+        if (strcmp(nodes[i].path, path) == 0)
+            return &nodes[i];
+        if (free_node == NULL && nodes[i].path[0] == '\0')
+            free_node = &nodes[i];
+    }
+
+    /* Only a handful of schedtune groups exist, this is not expected to happen. */
+    if (free_node == NULL) {
+        free_node = &nodes[0];
+        if (free_node->fd >= 0)
+            close(free_node->fd);
+    }
+
+    snprintf(free_node->path, sizeof(free_node->path), "%s", path);
+    free_node->fd = -1;
+    free_node->write_failed = false;
+
+    return free_node;
+}
+
+static int open_node(struct node *node) {
+    char path[PATH_MAX];
+
+    if (node->fd < 0) {
+        snprintf(path, sizeof(path), "%s%s", node_root, node->path);
+        node->fd = open(path, O_WRONLY | O_CLOEXEC);
+        if (node->fd >= 0)
+            atomic_fetch_add_explicit(&stat_opens, 1, memory_order_relaxed);
+    }
+
+    return node->fd;
+}
+
+bool node_writer_write(const char *path, const char *value) {
+    struct node *node = find_node(path);
+    int len = strlen(value);
+    int fd;
+
+    fd = open_node(node);
+    if (fd >= 0 && pwrite(fd, value, len, 0) == len) {
+        atomic_fetch_add_explicit(&stat_writes, 1, memory_order_relaxed);
+        node->write_failed = false;
+        return true;
+    }
+
+    atomic_fetch_add_explicit(&stat_failed, 1, memory_order_relaxed);
+
+    /* Callers without access to the node would flood the log. */
+    if (!node->write_failed) {
+        ALOGE("failed to write %s to %s: %s", value, path, strerror(errno));
+        node->write_failed = true;
+    }
+
+    /* Start over with a fresh fd next time. */
+    if (fd >= 0) {
+        close(fd);
+        node->fd = -1;
+    }
+
+    return false;
+}
+
+void node_writer_skip(void) {
+    atomic_fetch_add_explicit(&stat_skipped, 1, memory_order_relaxed);
+}
+
+void node_writer_get_stats(struct node_writer_stats *stats) {
+    stats->writes = atomic_load_explicit(&stat_writes, memory_order_relaxed);
+    stats->failed = atomic_load_explicit(&stat_failed, memory_order_relaxed);
+    stats->opens = atomic_load_explicit(&stat_opens, memory_order_relaxed);
+    stats->skipped = atomic_load_explicit(&stat_skipped, memory_order_relaxed);
+}
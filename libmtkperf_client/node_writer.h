@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Writes the nodes the engine still touches itself, the schedtune tasks
+ * files of the thread boost fallback. Nodes are kept open between writes
+ * and reopened after a failure.
+ *
+ * A tasks file takes a tid to move, not a value to hold: the framework
+ * moves threads between groups behind our back, so writing the same tid
+ * again is not redundant and nothing here caches it. Callers skip the
+ * writes they know change nothing.
+ *
+ * Apart from the statistics, only the engine thread may call these.
+ */
+
+#define NODE_WRITER_MAX 16
+
+struct node_writer_stats {
+    uint64_t writes;  /* values written to a node */
+    uint64_t failed;  /* writes that failed */
+    uint64_t opens;   /* nodes opened, including reopens after a failure */
+    uint64_t skipped; /* writes the caller found would change nothing */
+};
+
+/* Prefixes every node path with root, for running against a fake tree. */
+void node_writer_set_root(const char *root);
+
+/* Writes value to path, false if the node didn't take it. */
+bool node_writer_write(const char *path, const char *value);
+
+/* Counts a write the caller left out. */
+void node_writer_skip(void);
+
+void node_writer_get_stats(struct node_writer_stats *stats);
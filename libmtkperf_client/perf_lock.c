@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libmtkperf_client"
+
+#include "perf_lock.h"
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "node_writer.h"
+#include "perf_res.h"
+#include "perf_trace.h"
+#include "power_boost.h"
+#include "thread_boost.h"
+#include "timer_wheel.h"
+
+#define PERF_LOCK_MAX 64
+
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC 1000000000ULL
+#define TICK_NS (4 * NSEC_PER_MSEC)
+/* Changes arriving this soon after the first one are forwarded together. */
+#define BATCH_NS (1 * NSEC_PER_MSEC)
+#define BOOST_HOLD_NS (BOOST_HOLD_MS * NSEC_PER_MSEC)
+/* How long to leave the Power HAL alone after a failed hint. */
+#define BOOST_RETRY_NS (1000 * NSEC_PER_MSEC)
+
+/*
+ * A handle is the slot index in the low bits and the slot's generation
+ * above it, so a handle that was released and handed out again no longer
+ * matches its slot.
+ */
+#define HANDLE_SLOT_BITS 6
+#define HANDLE_GEN_MAX ((1U << (31 - HANDLE_SLOT_BITS)) - 1)
+
+/*
+ * Slot state: generation in the upper half, a version bumped by every
+ * change in bits 2..31, and the busy and live flags. Readers compare the
+ * whole word before and after reading a slot to get a consistent copy.
+ */
+#define STATE_LIVE 1ULL
+#define STATE_BUSY 2ULL
+#define STATE_VER 4ULL
+#define STATE_GEN(s) ((uint32_t)((s) >> 32))
+#define STATE_MAKE(gen, ver) (((uint64_t)(gen) << 32) | ((ver) & 0xFFFFFFFCULL))
+
+_Static_assert(PERF_LOCK_MAX == 1 << HANDLE_SLOT_BITS, "slot bits must cover the table");
+_Static_assert(PERF_LOCK_MAX <= TIMER_WHEEL_MAX_IDS, "timer wheel too small");
+_Static_assert(PERF_LOCK_MAX <= THREAD_BOOST_MAX, "thread boost table too small");
+
+struct perf_lock {
+    _Atomic uint64_t state;
+    /* CLOCK_MONOTONIC, 0 if held until released. */
+    _Atomic uint64_t expire_ns;
+    /* Mask of perf_res hints. */
+    _Atomic uint64_t hints;
+    /* Thread boosted by this lock, 0 for none. */
+    _Atomic int tid;
+    _Atomic int uclamp_min;
+    _Atomic int uclamp_max;
+} __attribute__((aligned(64)));
+
+static struct perf_lock locks[PERF_LOCK_MAX];
+/* Slots that can be claimed. */
+static _Atomic uint64_t free_mask = UINT64_MAX;
+/* Slots changed since the engine thread last looked. */
+static _Atomic uint64_t dirty_mask;
+
+static pthread_once_t engine_once = PTHREAD_ONCE_INIT;
+static int event_fd = -1;
+static int timer_fd = -1;
+
+/* Owned by the engine thread. */
+static struct timer_wheel wheel;
+/* End of each hint as last granted by the Power HAL. */
+static uint64_t hint_until_ns[PERF_HINT_COUNT];
+/* Hints that locks held until release need renewed. */
+static uint64_t held_hints;
+/* Earliest time to try again after a failed hint, 0 if none failed. */
+static uint64_t boost_retry_ns;
+
+static _Atomic uint64_t stat_boosts;
+static _Atomic uint64_t stat_boost_failed;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+/* Hands slot changes to the engine thread, waking it only when idle. */
+static void mark_dirty(int slot) {
+    if (atomic_fetch_or(&dirty_mask, 1ULL << slot) == 0)
+        eventfd_write(event_fd, 1);
+}
+
+/* Copies a live slot's hints, expiry and thread boost, false if it isn't live. */
+static bool read_slot(int slot, uint64_t *hints, uint64_t *expire,
+                      struct thread_boost_req *thread) {
+    struct perf_lock *lock = &locks[slot];
+    uint64_t before, after;
+
+    do {
+        before = atomic_load_explicit(&lock->state, memory_order_acquire);
+        if (!(before & STATE_LIVE))
+            return false;
+
+        /* Wait out an update instead of dropping the lock for a moment. */
+        if (before & STATE_BUSY) {
+            sched_yield();
+            after = 0;
+            continue;
+        }
+
+        *hints = atomic_load_explicit(&lock->hints, memory_order_relaxed);
+        *expire = atomic_load_explicit(&lock->expire_ns, memory_order_relaxed);
+        thread->tid = atomic_load_explicit(&lock->tid, memory_order_relaxed);
+        thread->uclamp_min = atomic_load_explicit(&lock->uclamp_min, memory_order_relaxed);
+        thread->uclamp_max = atomic_load_explicit(&lock->uclamp_max, memory_order_relaxed);
+
+        atomic_thread_fence(memory_order_acquire);
+        after = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    } while (before != after);
+
+    return true;
+}
+
+/*
+ * Fills in until when the live locks need each hint, 0 for hints nobody
+ * asks for, and brings boosted threads in line with the locks naming them.
+ * Returns the hints that need more than the HAL granted so far.
+ */
+static uint64_t update_locks(uint64_t now, uint64_t until[PERF_HINT_COUNT]) {
+    struct thread_boost_req threads[PERF_LOCK_MAX];
+    uint64_t expire, hints, pending = 0;
+    int slot, hint, thread_count = 0;
+
+    held_hints = 0;
+    memset(until, 0, PERF_HINT_COUNT * sizeof(until[0]));
+
+    for (slot = 0; slot < PERF_LOCK_MAX; slot++) {
+        if (!read_slot(slot, &hints, &expire, &threads[thread_count]))
+            continue;
+
+        if (threads[thread_count].tid > 0)
+            thread_count++;
+
+        /* A lock that is due but not yet dropped adds nothing. */
+        if (expire == 0) {
+            held_hints |= hints;
+            continue;
+        }
+        for (; hints && expire > now; hints &= hints - 1) {
+            hint = __builtin_ctzll(hints);
+            if (expire > until[hint])
+                until[hint] = expire;
+        }
+    }
+
+    for (hint = 0; hint < PERF_HINT_COUNT; hint++) {
+        /* Renew once half of the previous step is used up. */
+        if (held_hints & (1ULL << hint)) {
+            expire = hint_until_ns[hint] > now + BOOST_HOLD_NS / 2 ? hint_until_ns[hint]
+                                                                   : now + BOOST_HOLD_NS;
+            if (expire > until[hint])
+                until[hint] = expire;
+        }
+
+        if (until[hint] > hint_until_ns[hint])
+            pending |= 1ULL << hint;
+    }
+
+    thread_boost_update(threads, thread_count);
+
+    return pending;
+}
+
+/*
+ * libperfmgr keeps a timed request per hint and resolves the requests of
+ * all hints per node, so each hint only needs the later end time.
+ */
+static void forward_hints(uint64_t now, const uint64_t until[PERF_HINT_COUNT],
+                          uint64_t pending) {
+    char name[64];
+    int hint, duration_ms;
+
+    for (; pending; pending &= pending - 1) {
+        hint = __builtin_ctzll(pending);
+        duration_ms = (until[hint] - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+        perf_res_hint_name(hint, name, sizeof(name));
+
+        if (!power_boost_hint(name, duration_ms)) {
+            /* Callers without access to the HAL would flood the log. */
+            if (atomic_fetch_add_explicit(&stat_boost_failed, 1, memory_order_relaxed) == 0)
+                ALOGE("failed to send %s to the Power HAL", name);
+
+            boost_retry_ns = now + BOOST_RETRY_NS;
+            return;
+        }
+
+        atomic_fetch_add_explicit(&stat_boosts, 1, memory_order_relaxed);
+        hint_until_ns[hint] = until[hint];
+    }
+
+    boost_retry_ns = 0;
+}
+
+/* Drops a timed lock once it is due, unless it was extended meanwhile. */
+static void expire_slot(int slot, void *arg) {
+    struct perf_lock *lock = &locks[slot];
+    uint64_t now = *(uint64_t *)arg;
+    uint64_t state = atomic_load_explicit(&lock->state, memory_order_acquire);
+    uint64_t expire = atomic_load_explicit(&lock->expire_ns, memory_order_relaxed);
+
+    if (!(state & STATE_LIVE) || (state & STATE_BUSY) || expire == 0 || expire > now)
+        return;
+
+    if (atomic_compare_exchange_strong(&lock->state, &state,
+            STATE_MAKE(STATE_GEN(state), state + STATE_VER))) {
+        atomic_fetch_or(&free_mask, 1ULL << slot);
+        perf_trace_record(PERF_TRACE_EXPIRE, (int)(STATE_GEN(state) << HANDLE_SLOT_BITS) | slot,
+                0, -1, NULL, NULL);
+    }
+}
+
+/* Moves changed slots to their place in the timer wheel. */
+static void schedule_dirty(void) {
+    uint64_t dirty = atomic_exchange(&dirty_mask, 0);
+
+    while (dirty) {
+        int slot = __builtin_ctzll(dirty);
+        struct perf_lock *lock = &locks[slot];
+        uint64_t state = atomic_load_explicit(&lock->state, memory_order_acquire);
+        uint64_t expire = atomic_load_explicit(&lock->expire_ns, memory_order_relaxed);
+
+        dirty &= dirty - 1;
+
+        timer_wheel_del(&wheel, slot);
+        if ((state & STATE_LIVE) && expire != 0)
+            timer_wheel_add(&wheel, slot, (expire + TICK_NS - 1) / TICK_NS);
+    }
+}
+
+static void arm_timer(void) {
+    struct itimerspec spec;
+    uint64_t next = timer_wheel_next(&wheel);
+
+    memset(&spec, 0, sizeof(spec));
+    if (next != UINT64_MAX) {
+        spec.it_value.tv_sec = next * TICK_NS / NSEC_PER_SEC;
+        spec.it_value.tv_nsec = next * TICK_NS % NSEC_PER_SEC;
+    }
+
+    if (timerfd_settime(timer_fd, TFD_TIMER_ABSTIME, &spec, NULL) != 0)
+        ALOGE("failed to arm perf lock timer: %s", strerror(errno));
+}
+
+/* Next time the engine has to run without being woken, 0 if never. */
+static uint64_t next_wakeup(uint64_t flush_ns) {
+    uint64_t renew, held, wakeup = flush_ns;
+    int hint;
+
+    if (boost_retry_ns != 0) {
+        if (wakeup == 0 || boost_retry_ns < wakeup)
+            wakeup = boost_retry_ns;
+        return wakeup;
+    }
+
+    for (held = held_hints; held; held &= held - 1) {
+        hint = __builtin_ctzll(held);
+
+        /* Not granted yet, the pending batch sends it. */
+        if (hint_until_ns[hint] == 0)
+            continue;
+
+        renew = hint_until_ns[hint] - BOOST_HOLD_NS / 2;
+        if (wakeup == 0 || renew < wakeup)
+            wakeup = renew;
+    }
+
+    return wakeup;
+}
+
+static void *engine_loop(void *arg) {
+    struct pollfd fds[] = {
+        { event_fd, POLLIN, 0 },
+        { timer_fd, POLLIN, 0 },
+    };
+    struct timespec timeout;
+    uint64_t until[PERF_HINT_COUNT];
+    uint64_t unused, now, pending, wakeup, flush_ns = 0;
+
+    (void)arg;
+
+    for (;;) {
+        /* Hold a started batch open until its window closes, renew or retry on time. */
+        wakeup = next_wakeup(flush_ns);
+        if (wakeup != 0) {
+            now = now_ns();
+            timeout.tv_sec = wakeup > now ? (wakeup - now) / NSEC_PER_SEC : 0;
+            timeout.tv_nsec = wakeup > now ? (wakeup - now) % NSEC_PER_SEC : 0;
+        }
+
+        if (ppoll(fds, 2, wakeup != 0 ? &timeout : NULL, NULL) < 0) {
+            if (errno == EINTR)
+                continue;
+            ALOGE("failed to wait for perf lock changes: %s", strerror(errno));
+            return NULL;
+        }
+
+        if (fds[0].revents & POLLIN)
+            read(event_fd, &unused, sizeof(unused));
+        if (fds[1].revents & POLLIN)
+            read(timer_fd, &unused, sizeof(unused));
+
+        now = now_ns();
+        timer_wheel_advance(&wheel, now / TICK_NS, expire_slot, &now);
+        schedule_dirty();
+        pending = update_locks(now, until);
+        arm_timer();
+
+        if (boost_retry_ns != 0 && now >= boost_retry_ns)
+            boost_retry_ns = 0;
+
+        if (pending == 0 || boost_retry_ns != 0) {
+            flush_ns = 0;
+        } else if (flush_ns == 0) {
+            flush_ns = now + BATCH_NS;
+        } else if (now >= flush_ns) {
+            forward_hints(now, until, pending);
+            flush_ns = 0;
+        }
+    }
+}
+
+static void engine_init(void) {
+    pthread_t thread;
+    timer_wheel_init(&wheel, now_ns() / TICK_NS);
+
+    event_fd = eventfd(0, EFD_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (event_fd < 0 || timer_fd < 0) {
+        ALOGE("failed to create perf lock engine fds: %s", strerror(errno));
+        return;
+    }
+
+    if (pthread_create(&thread, NULL, engine_loop, NULL) != 0) {
+        ALOGE("failed to start perf lock engine thread");
+        return;
+    }
+    pthread_detach(thread);
+
+    perf_trace_watch();
+}
+
+static void store_slot(struct perf_lock *lock, int duration_ms, uint64_t hints,
+                       const struct thread_boost_req *thread) {
+    atomic_store_explicit(&lock->expire_ns,
+            duration_ms > 0 ? now_ns() + duration_ms * NSEC_PER_MSEC : 0, memory_order_relaxed);
+    atomic_store_explicit(&lock->hints, hints, memory_order_relaxed);
+    atomic_store_explicit(&lock->tid, thread != NULL ? thread->tid : 0, memory_order_relaxed);
+    atomic_store_explicit(&lock->uclamp_min, thread != NULL ? thread->uclamp_min : 0,
+            memory_order_relaxed);
+    atomic_store_explicit(&lock->uclamp_max, thread != NULL ? thread->uclamp_max : 0,
+            memory_order_relaxed);
+}
+
+/* Rewrites a live lock in place, false if the handle went stale. */
+static bool update_lock(int handle, int duration_ms, uint64_t hints,
+                        const struct thread_boost_req *thread) {
+    int slot = handle & (PERF_LOCK_MAX - 1);
+    uint32_t gen = (uint32_t)handle >> HANDLE_SLOT_BITS;
+    struct perf_lock *lock = &locks[slot];
+    uint64_t state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+
+    for (;;) {
+        if (STATE_GEN(state) != gen || !(state & STATE_LIVE))
+            return false;
+
+        /* Another thread is updating the same handle. */
+        if (state & STATE_BUSY) {
+            state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&lock->state, &state, state | STATE_BUSY,
+                memory_order_acquire, memory_order_relaxed))
+            break;
+    }
+
+    store_slot(lock, duration_ms, hints, thread);
+    atomic_store_explicit(&lock->state, STATE_MAKE(gen, state + STATE_VER) | STATE_LIVE,
+            memory_order_release);
+    mark_dirty(slot);
+
+    return true;
+}
+
+int perf_engine_acquire(int handle, int duration_ms, uint64_t hints,
+                        const struct thread_boost_req *thread) {
+    struct perf_lock *lock;
+    uint64_t mask, state;
+    uint32_t gen;
+    int slot;
+
+    pthread_once(&engine_once, engine_init);
+
+    if (handle > 0 && update_lock(handle, duration_ms, hints, thread))
+        return handle;
+
+    mask = atomic_load_explicit(&free_mask, memory_order_relaxed);
+    do {
+        if (mask == 0) {
+            ALOGE("out of perf lock slots");
+            return -1;
+        }
+        slot = __builtin_ctzll(mask);
+    } while (!atomic_compare_exchange_weak_explicit(&free_mask, &mask, mask & ~(1ULL << slot),
+            memory_order_acquire, memory_order_relaxed));
+
+    /* The slot is ours alone until it is published live. */
+    lock = &locks[slot];
+    state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    gen = STATE_GEN(state) == HANDLE_GEN_MAX ? 1 : STATE_GEN(state) + 1;
+
+    store_slot(lock, duration_ms, hints, thread);
+    atomic_store_explicit(&lock->state, STATE_MAKE(gen, state + STATE_VER) | STATE_LIVE,
+            memory_order_release);
+    mark_dirty(slot);
+
+    return (int)(gen << HANDLE_SLOT_BITS) | slot;
+}
+
+int perf_engine_release(int handle) {
+    int slot = handle & (PERF_LOCK_MAX - 1);
+    uint32_t gen = (uint32_t)handle >> HANDLE_SLOT_BITS;
+    struct perf_lock *lock = &locks[slot];
+    uint64_t state;
+
+    if (handle <= 0)
+        return -1;
+
+    state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+    for (;;) {
+        if (STATE_GEN(state) != gen || !(state & STATE_LIVE))
+            return -1;
+
+        if (state & STATE_BUSY) {
+            state = atomic_load_explicit(&lock->state, memory_order_relaxed);
+            continue;
+        }
+
+        if (atomic_compare_exchange_weak_explicit(&lock->state, &state,
+                STATE_MAKE(gen, state + STATE_VER), memory_order_release, memory_order_relaxed))
+            break;
+    }
+
+    atomic_fetch_or_explicit(&free_mask, 1ULL << slot, memory_order_release);
+    mark_dirty(slot);
+
+    return 0;
+}
+
+void perf_engine_dump(int fd) {
+    struct thread_boost_stats threads;
+    struct node_writer_stats nodes;
+
+    thread_boost_get_stats(&threads);
+    node_writer_get_stats(&nodes);
+    dprintf(fd, "perf locks held: %d of %d\n",
+            PERF_LOCK_MAX - __builtin_popcountll(atomic_load(&free_mask)), PERF_LOCK_MAX);
+    dprintf(fd, "Power HAL hints: %" PRIu64 " sent, %" PRIu64 " failed\n",
+            atomic_load_explicit(&stat_boosts, memory_order_relaxed),
+            atomic_load_explicit(&stat_boost_failed, memory_order_relaxed));
+    dprintf(fd, "thread boosts: %" PRIu64 " applied, %" PRIu64 " via schedtune, %" PRIu64
+            " restored, %" PRIu64 " failed\n", threads.applied, threads.fallback, threads.restored,
+            threads.failed);
+    dprintf(fd, "node writes: %" PRIu64 " failed: %" PRIu64 " skipped: %" PRIu64 " opens: %" PRIu64
+            "\n", nodes.writes, nodes.failed, nodes.skipped, nodes.opens);
+}
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "thread_boost.h"
+
+#define BOOST_HOLD_MS 1000
+
+/*
+ * Takes or updates a lock. A positive handle of a live lock replaces that
+ * lock, anything else allocates a new one. The lock is dropped after
+ * duration_ms, or only on release if it is 0.
+ *
+ * hints is a mask of perf_res hints. Each of them is held in the Power HAL
+ * at least as long as the lock. A lock held until release renews them
+ * BOOST_HOLD_MS at a time, so a hint may outlive the release by up to that
+ * much.
+ *
+ * thread, if not NULL, also clamps the utilization of that one thread for
+ * as long as the lock is held.
+ *
+ * Neither call blocks: the engine thread forwards hints to the HAL
+ * shortly after, and also runs the expiry timers.
+ *
+ * Returns the handle, or -1 if all lock slots are in use.
+ */
+int perf_engine_acquire(int handle, int duration_ms, uint64_t hints,
+                        const struct thread_boost_req *thread);
+
+/* Returns 0, or -1 if the handle isn't held. */
+int perf_engine_release(int handle);
+
+/* Prints the engine's state and boost statistics to fd. */
+void perf_engine_dump(int fd);
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <mtkperf_client.h>
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <time.h>
+
+/* A cap only, so the Power HAL is left out and the engine alone is measured. */
+static int cap_list[] = { 0x00404100, 1500000 };
+
+static uint64_t now_ns() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Per thread latencies of the last kSamples calls. Each thread reports its
+ * own percentiles, averaged over the threads.
+ */
+class Latencies {
+  public:
+    static constexpr size_t kSamples = 1 << 16;
+
+    Latencies() : mSamples(kSamples), mCount(0) {}
+
+    void add(uint64_t ns) { mSamples[mCount++ & (kSamples - 1)] = ns; }
+
+    void report(benchmark::State& state) {
+        size_t count = std::min(mCount, kSamples);
+
+        if (count == 0)
+            return;
+
+        mSamples.resize(count);
+        std::sort(mSamples.begin(), mSamples.end());
+
+        state.counters["p50_ns"] = benchmark::Counter(
+                mSamples[count / 2], benchmark::Counter::kAvgThreads);
+        state.counters["p99_ns"] = benchmark::Counter(
+                mSamples[count * 99 / 100], benchmark::Counter::kAvgThreads);
+        state.counters["p999_ns"] = benchmark::Counter(
+                mSamples[count * 999 / 1000], benchmark::Counter::kAvgThreads);
+    }
+
+  private:
+    std::vector<uint64_t> mSamples;
+    size_t mCount;
+};
+
+/* Take a lock and drop it again, a tap or a frame boost. */
+static void BM_AcquireRelease(benchmark::State& state) {
+    Latencies latencies;
+
+    for (auto _ : state) {
+        uint64_t start = now_ns();
+        int hdl = perf_lock_acq(0, 0, cap_list, 2);
+
+        perf_lock_rel(hdl);
+        latencies.add(now_ns() - start);
+
+        if (hdl < 0) {
+            state.SkipWithError("out of perf lock slots");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    latencies.report(state);
+}
+BENCHMARK(BM_AcquireRelease)->ThreadRange(1, 8)->UseRealTime();
+
+/* Keep extending one timed lock, as the camera does for every frame. */
+static void BM_Renew(benchmark::State& state) {
+    Latencies latencies;
+    int hdl = 0;
+
+    for (auto _ : state) {
+        uint64_t start = now_ns();
+
+        hdl = perf_lock_acq(hdl, 100, cap_list, 2);
+        latencies.add(now_ns() - start);
+
+        if (hdl < 0) {
+            state.SkipWithError("out of perf lock slots");
+            break;
+        }
+    }
+
+    perf_lock_rel(hdl);
+    state.SetItemsProcessed(state.iterations());
+    latencies.report(state);
+}
+BENCHMARK(BM_Renew)->ThreadRange(1, 8)->UseRealTime();
+
+/*
+ * The design the lock table replaced: handles in a map behind one mutex,
+ * with no engine or trace behind it. Only here for comparison.
+ */
+static std::mutex baseline_lock;
+static std::map<int, uint64_t> baseline_locks;
+static int baseline_next;
+
+static void BM_MutexMapBaseline(benchmark::State& state) {
+    Latencies latencies;
+
+    for (auto _ : state) {
+        uint64_t start = now_ns();
+        int hdl;
+        {
+            std::lock_guard<std::mutex> lock(baseline_lock);
+            hdl = ++baseline_next;
+            baseline_locks[hdl] = start;
+        }
+        {
+            std::lock_guard<std::mutex> lock(baseline_lock);
+            baseline_locks.erase(hdl);
+        }
+        latencies.add(now_ns() - start);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    latencies.report(state);
+}
+BENCHMARK(BM_MutexMapBaseline)->ThreadRange(1, 8)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "perf_res.h"
+
+#include <stdio.h>
+
+/* MediaTek perf resource opcodes, see mtkperf_resource.h */
+#define PERF_RES_CPUFREQ_MIN_CLUSTER_0  0x00400000
+#define PERF_RES_CPUFREQ_MIN_CLUSTER_1  0x00400100
+#define PERF_RES_CPUFREQ_MAX_CLUSTER_0  0x00404000
+#define PERF_RES_CPUFREQ_MAX_CLUSTER_1  0x00404100
+#define PERF_RES_DRAM_OPP_MIN           0x01000000
+
+#define ARRAY_SIZE(a) ((int)(sizeof(a) / sizeof((a)[0])))
+
+/* The Values of each node in powerhint.json, less the unset one. */
+static const int cpu_l_levels[] = {
+    1800000, 1625000, 1500000, 1450000, 1375000, 1325000, 1275000, 1175000,
+    1100000, 1050000, 999000, 950000, 900000, 850000, 774000, 500000,
+};
+
+static const int cpu_b_levels[] = {
+    2000000, 1950000, 1900000, 1850000, 1800000, 1710000, 1621000, 1532000,
+    1443000, 1354000, 1295000, 1176000, 1087000, 998000, 909000, 850000,
+};
+
+static const int dram_opp_levels[] = { 0, 1, 2 };
+
+const struct perf_res perf_res_table[PERF_NODE_COUNT] = {
+    [PERF_NODE_CPU_L_MIN] = { "CPULittleClusterMinFreq", -1, "CPU_L_MIN",
+            cpu_l_levels, ARRAY_SIZE(cpu_l_levels), 0 },
+    [PERF_NODE_CPU_L_MAX] = { "CPULittleClusterMaxFreq", -1, NULL, NULL, 0, 0 },
+    [PERF_NODE_CPU_B_MIN] = { "CPUBigClusterMinFreq", -1, "CPU_B_MIN",
+            cpu_b_levels, ARRAY_SIZE(cpu_b_levels), 0 },
+    [PERF_NODE_CPU_B_MAX] = { "CPUBigClusterMaxFreq", -1, NULL, NULL, 0, 0 },
+    [PERF_NODE_DRAM_OPP_MIN] = { "DRAMOppMin", -1, "DRAM_OPP_MIN",
+            dram_opp_levels, ARRAY_SIZE(dram_opp_levels), 1 },
+};
+
+_Static_assert(ARRAY_SIZE(cpu_l_levels) + ARRAY_SIZE(cpu_b_levels) +
+        ARRAY_SIZE(dram_opp_levels) + 1 == PERF_HINT_COUNT, "hint count out of date");
+_Static_assert(PERF_HINT_COUNT <= 64, "hints must fit a lock's mask");
+
+static const struct {
+    int opcode;
+    enum perf_node node;
+} opcodes[] = {
+    { PERF_RES_CPUFREQ_MIN_CLUSTER_0, PERF_NODE_CPU_L_MIN },
+    { PERF_RES_CPUFREQ_MIN_CLUSTER_1, PERF_NODE_CPU_B_MIN },
+    { PERF_RES_CPUFREQ_MAX_CLUSTER_0, PERF_NODE_CPU_L_MAX },
+    { PERF_RES_CPUFREQ_MAX_CLUSTER_1, PERF_NODE_CPU_B_MAX },
+    { PERF_RES_DRAM_OPP_MIN, PERF_NODE_DRAM_OPP_MIN },
+};
+
+int perf_res_lookup(int opcode) {
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(opcodes); i++) {
+        if (opcodes[i].opcode == opcode)
+            return opcodes[i].node;
+    }
+
+    return -1;
+}
+
+/* First hint of node, its levels follow in order. */
+static int hint_base(int node) {
+    int base = 0, n;
+
+    for (n = 0; n < node; n++)
+        base += perf_res_table[n].level_count;
+
+    return base;
+}
+
+int perf_res_hint(int node, int value) {
+    const struct perf_res *res = &perf_res_table[node];
+    int level;
+
+    if (res->hint == NULL)
+        return -1;
+
+    /* Walk up from the weakest level until one covers the request. */
+    for (level = res->level_count - 1; level > 0; level--) {
+        if (res->descending ? res->levels[level] <= value : res->levels[level] >= value)
+            break;
+    }
+
+    return hint_base(node) + level;
+}
+
+void perf_res_hint_name(int hint, char *buf, size_t size) {
+    int node, base = 0;
+
+    if (hint == PERF_HINT_CUS) {
+        snprintf(buf, size, "MTKPERF_CUS_HINT");
+        return;
+    }
+
+    for (node = 0; node < PERF_NODE_COUNT; node++) {
+        const struct perf_res *res = &perf_res_table[node];
+
+        if (hint < base + res->level_count) {
+            snprintf(buf, size, "MTKPERF_%s_%d", res->hint, res->levels[hint - base]);
+            return;
+        }
+        base += res->level_count;
+    }
+
+    snprintf(buf, size, "MTKPERF_INVALID");
+}
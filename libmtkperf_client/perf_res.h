@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+/*
+ * Tunables a perf lock can name. Every one of them is also a node in
+ * configs/powerhint.json, named in the comment. Those nodes belong to
+ * libperfmgr in the Power HAL, so locks never write them. A floor is
+ * asked for through the powerhint.json hint that raises that one node to
+ * that level, and libperfmgr resolves overlapping requests per node. Caps
+ * are left to powerhint.json and the thermal governor.
+ */
+enum perf_node {
+    PERF_NODE_CPU_L_MIN,    /* CPULittleClusterMinFreq */
+    PERF_NODE_CPU_L_MAX,    /* CPULittleClusterMaxFreq */
+    PERF_NODE_CPU_B_MIN,    /* CPUBigClusterMinFreq */
+    PERF_NODE_CPU_B_MAX,    /* CPUBigClusterMaxFreq */
+    PERF_NODE_DRAM_OPP_MIN, /* DRAMOppMin */
+    PERF_NODE_COUNT,
+};
+
+struct perf_res {
+    const char *name;
+    /* Means the lock leaves the node alone, also never a lock value. */
+    int unset;
+    /*
+     * Hint names are "MTKPERF_<hint>_<level>", one per level, strongest
+     * first as in the node's Values. NULL for caps, which get no hints.
+     */
+    const char *hint;
+    const int *levels;
+    int level_count;
+    /* A lower value is the stronger floor, as with DRAM OPPs. */
+    int descending;
+};
+
+extern const struct perf_res perf_res_table[PERF_NODE_COUNT];
+
+/*
+ * Hints are numbered per node and level, followed by the one hint every
+ * customer hint maps to.
+ */
+#define PERF_HINT_CUS (PERF_HINT_COUNT - 1)
+#define PERF_HINT_COUNT 36
+
+/* Returns the node for a MediaTek resource opcode, or -1 if unsupported. */
+int perf_res_lookup(int opcode);
+
+/*
+ * Returns the hint for the weakest level of node that still meets value,
+ * the strongest one if none does, or -1 if the node takes no hints.
+ */
+int perf_res_hint(int node, int value);
+
+/* Writes the powerhint.json name of hint to buf. */
+void perf_res_hint_name(int hint, char *buf, size_t size);
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libmtkperf_client"
+
+#include "perf_trace.h"
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/system_properties.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#define CALLER_NAME_LEN 96
+#define NODE_NAME_LEN 32
+
+_Static_assert((PERF_TRACE_EVENTS & (PERF_TRACE_EVENTS - 1)) == 0, "ring size must be a power of two");
+
+struct slot {
+    /* Index + 1 of the event in the slot, 0 while it is being written. */
+    _Atomic uint64_t seq;
+    struct perf_trace_record record;
+};
+
+static struct slot ring[PERF_TRACE_EVENTS];
+static _Atomic uint64_t head;
+
+void perf_trace_record(enum perf_trace_type type, int handle, int duration_ms, int hint,
+                       const int values[PERF_NODE_COUNT], const void *caller) {
+    uint64_t index = atomic_fetch_add_explicit(&head, 1, memory_order_relaxed);
+    struct slot *slot = &ring[index & (PERF_TRACE_EVENTS - 1)];
+    struct perf_trace_record *record = &slot->record;
+    struct timespec ts;
+    int node;
+
+    atomic_store_explicit(&slot->seq, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    record->time_ns = ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+    record->caller = (uintptr_t)caller;
+    record->tid = gettid();
+    record->handle = handle;
+    record->duration_ms = duration_ms;
+    record->hint = hint;
+    record->type = type;
+    for (node = 0; node < PERF_NODE_COUNT; node++)
+        record->values[node] = values ? values[node] : perf_res_table[node].unset;
+
+    atomic_store_explicit(&slot->seq, index + 1, memory_order_release);
+}
+
+/* Copies event index out of the ring, false if it was overwritten. */
+static bool read_event(uint64_t index, struct perf_trace_record *record) {
+    struct slot *slot = &ring[index & (PERF_TRACE_EVENTS - 1)];
+
+    if (atomic_load_explicit(&slot->seq, memory_order_acquire) != index + 1)
+        return false;
+
+    memcpy(record, &slot->record, sizeof(*record));
+
+    atomic_thread_fence(memory_order_acquire);
+    return atomic_load_explicit(&slot->seq, memory_order_relaxed) == index + 1;
+}
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+
+        if (n <= 0)
+            return -1;
+        p += n;
+        len -= n;
+    }
+
+    return 0;
+}
+
+int perf_trace_dump(int fd) {
+    struct perf_trace_header header;
+    struct perf_trace_record *events;
+    uint64_t *callers;
+    uint64_t end, start, i;
+    uint32_t count = 0, ncallers = 0, c;
+    int ret = -1;
+
+    events = calloc(PERF_TRACE_EVENTS, sizeof(*events));
+    callers = calloc(PERF_TRACE_EVENTS, sizeof(*callers));
+    if (events == NULL || callers == NULL)
+        goto out;
+
+    end = atomic_load_explicit(&head, memory_order_acquire);
+    start = end > PERF_TRACE_EVENTS ? end - PERF_TRACE_EVENTS : 0;
+
+    for (i = start; i < end; i++) {
+        if (!read_event(i, &events[count]))
+            continue;
+
+        for (c = 0; c < ncallers && callers[c] != events[count].caller; c++)
+            ;
+        if (c == ncallers && events[count].caller != 0)
+            callers[ncallers++] = events[count].caller;
+        count++;
+    }
+
+    header.magic = PERF_TRACE_MAGIC;
+    header.version = PERF_TRACE_VERSION;
+    header.pid = getpid();
+    header.node_count = PERF_NODE_COUNT;
+    header.caller_count = ncallers;
+    header.event_count = count;
+    header.record_size = sizeof(struct perf_trace_record);
+    if (write_all(fd, &header, sizeof(header)) != 0)
+        goto out;
+
+    for (i = 0; i < PERF_NODE_COUNT; i++) {
+        char name[NODE_NAME_LEN] = {};
+
+        strncpy(name, perf_res_table[i].name, sizeof(name) - 1);
+        if (write_all(fd, name, sizeof(name)) != 0 ||
+                write_all(fd, &perf_res_table[i].unset, sizeof(int32_t)) != 0)
+            goto out;
+    }
+
+    /* Resolving here keeps dladdr() off the tracing path. */
+    for (c = 0; c < ncallers; c++) {
+        char name[CALLER_NAME_LEN] = {};
+        Dl_info info;
+
+        if (dladdr((void *)(uintptr_t)callers[c], &info) && info.dli_fname != NULL)
+            strncpy(name, info.dli_fname, sizeof(name) - 1);
+
+        if (write_all(fd, &callers[c], sizeof(callers[c])) != 0 ||
+                write_all(fd, name, sizeof(name)) != 0)
+            goto out;
+    }
+
+    if (write_all(fd, events, count * sizeof(*events)) != 0)
+        goto out;
+
+    ret = 0;
+
+out:
+    free(events);
+    free(callers);
+    return ret;
+}
+
+static void dump_to_file(void) {
+    char comm[16] = "unknown", path[PATH_MAX], *c;
+    ssize_t len;
+    int fd;
+
+    fd = open("/proc/self/comm", O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        len = read(fd, comm, sizeof(comm) - 1);
+        if (len > 0)
+            comm[len] = '\0';
+        close(fd);
+    }
+    comm[strcspn(comm, "\n")] = '\0';
+    for (c = comm; *c != '\0'; c++) {
+        if (*c == '/')
+            *c = '_';
+    }
+
+    snprintf(path, sizeof(path), "%s/%s-%d.trace", PERF_TRACE_DUMP_DIR, comm, getpid());
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0640);
+    if (fd < 0) {
+        ALOGE("failed to open %s: %s", path, strerror(errno));
+        return;
+    }
+
+    if (perf_trace_dump(fd) != 0)
+        ALOGE("failed to write %s: %s", path, strerror(errno));
+    else
+        ALOGI("perf lock trace written to %s", path);
+    close(fd);
+}
+
+static void *watch_loop(void *arg) {
+    const prop_info *pi = arg;
+    uint32_t serial = __system_property_serial(pi);
+
+    for (;;) {
+        if (__system_property_wait(pi, serial, &serial, NULL))
+            dump_to_file();
+    }
+
+    return NULL;
+}
+
+void perf_trace_watch(void) {
+    const prop_info *pi = __system_property_find(PERF_TRACE_DUMP_PROP);
+    pthread_t thread;
+
+    /* Set at boot, see init.mt6768.rc. */
+    if (pi == NULL) {
+        ALOGW("%s not found, trace dumps disabled", PERF_TRACE_DUMP_PROP);
+        return;
+    }
+
+    if (pthread_create(&thread, NULL, watch_loop, (void *)pi) != 0) {
+        ALOGE("failed to start perf trace watcher");
+        return;
+    }
+    pthread_detach(thread);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "perf_res.h"
+
+/*
+ * Flight recorder for perf lock activity. The most recent
+ * PERF_TRACE_EVENTS events are kept in a lock-free ring and written out
+ * in binary on request, perf_trace_report.py turns a dump into per-caller
+ * totals and a Perfetto timeline.
+ *
+ * Changing PERF_TRACE_DUMP_PROP to any new value makes every process using
+ * the library write its trace to PERF_TRACE_DUMP_DIR/<comm>-<pid>.trace.
+ */
+
+#define PERF_TRACE_EVENTS 1024
+
+#define PERF_TRACE_DUMP_PROP "vendor.perf_trace.dump"
+#define PERF_TRACE_DUMP_DIR "/data/vendor/perf_trace"
+
+#define PERF_TRACE_MAGIC 0x5254504d /* "MPTR" */
+#define PERF_TRACE_VERSION 1
+
+enum perf_trace_type {
+    PERF_TRACE_ACQUIRE,
+    PERF_TRACE_RELEASE,
+    PERF_TRACE_EXPIRE,
+    PERF_TRACE_HINT,
+};
+
+/*
+ * Dump layout, all little endian:
+ *   struct perf_trace_header
+ *   node_count x { char[32]; int32_t }        node names and unset values
+ *   caller_count x { uint64_t pc; char[96] }  callers resolved to libraries
+ *   event_count x struct perf_trace_record
+ */
+struct perf_trace_header {
+    uint32_t magic;
+    uint32_t version;
+    int32_t pid;
+    uint32_t node_count;
+    uint32_t caller_count;
+    uint32_t event_count;
+    uint32_t record_size;
+};
+
+struct perf_trace_record {
+    uint64_t time_ns; /* CLOCK_MONOTONIC */
+    uint64_t caller;  /* return address into the calling library, 0 for expiry */
+    int32_t tid;
+    int32_t handle;
+    int32_t duration_ms;
+    int32_t hint;     /* customer hint, -1 otherwise */
+    uint32_t type;
+    int32_t values[PERF_NODE_COUNT];
+};
+
+/* values may be NULL for events that don't carry any. */
+void perf_trace_record(enum perf_trace_type type, int handle, int duration_ms, int hint,
+                       const int values[PERF_NODE_COUNT], const void *caller);
+
+/* Returns 0, or -1 if writing to fd failed. */
+int perf_trace_dump(int fd);
+
+/* Starts the thread that dumps the trace whenever PERF_TRACE_DUMP_PROP changes. */
+void perf_trace_watch(void);
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2023 The LineageOS Project
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+
+"""
+Summarizes a libmtkperf_client trace written by perf_lock_dump_trace(), or
+pulled from /data/vendor/perf_trace after setting vendor.perf_trace.dump:
+prints how long every calling library held each node and optionally writes
+a Chrome JSON timeline that ui.perfetto.dev can open.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+from collections import defaultdict
+
+MAGIC = 0x5254504d
+VERSION = 1
+
+HEADER = struct.Struct('<IIiIIII')
+NODE = struct.Struct('<32si')
+CALLER = struct.Struct('<Q96s')
+RECORD_FIXED = struct.Struct('<QQiiiiI')
+
+ACQUIRE, RELEASE, EXPIRE, HINT = range(4)
+TYPE_NAMES = ['acquire', 'release', 'expire', 'hint']
+
+
+def cstr(raw):
+    return raw.split(b'\0', 1)[0].decode('utf-8', 'replace')
+
+
+def parse(data):
+    magic, version, pid, node_count, caller_count, event_count, record_size = \
+        HEADER.unpack_from(data, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit('not a perf trace, or an unsupported version')
+    offset = HEADER.size
+
+    nodes = []
+    for _ in range(node_count):
+        name, unset = NODE.unpack_from(data, offset)
+        nodes.append((cstr(name), unset))
+        offset += NODE.size
+
+    callers = {}
+    for _ in range(caller_count):
+        pc, name = CALLER.unpack_from(data, offset)
+        callers[pc] = os.path.basename(cstr(name)) or hex(pc)
+        offset += CALLER.size
+
+    values = struct.Struct('<%di' % node_count)
+    events = []
+    for _ in range(event_count):
+        time_ns, caller, tid, handle, duration, hint, type = \
+            RECORD_FIXED.unpack_from(data, offset)
+        vals = values.unpack_from(data, offset + RECORD_FIXED.size)
+        events.append({
+            'time_ns': time_ns,
+            'caller': callers.get(caller, 'engine'),
+            'tid': tid,
+            'handle': handle,
+            'duration_ms': duration,
+            'hint': hint,
+            'type': type,
+            'values': vals,
+        })
+        offset += record_size
+
+    return pid, nodes, events
+
+
+def build_spans(events):
+    """Turns events into (start, end, acquiring event, end reason) spans per handle."""
+    open_spans = {}
+    spans = []
+    last = events[-1]['time_ns'] if events else 0
+
+    for event in events:
+        handle = event['handle']
+        if event['type'] in (ACQUIRE, HINT):
+            if handle in open_spans:
+                start = open_spans.pop(handle)
+                spans.append((start['time_ns'], event['time_ns'], start, 'replaced'))
+            if handle > 0:
+                open_spans[handle] = event
+        elif handle in open_spans:
+            start = open_spans.pop(handle)
+            spans.append((start['time_ns'], event['time_ns'], start, TYPE_NAMES[event['type']]))
+
+    for start in open_spans.values():
+        spans.append((start['time_ns'], last, start, 'held'))
+
+    return sorted(spans, key=lambda span: span[0])
+
+
+def report(nodes, spans):
+    totals = defaultdict(lambda: {'locks': 0, 'ms': 0.0, 'nodes': defaultdict(float),
+                                  'max': {}})
+
+    for start, end, event, _ in spans:
+        caller = totals[event['caller']]
+        held_ms = (end - start) / 1e6
+        caller['locks'] += 1
+        caller['ms'] += held_ms
+        for (name, unset), value in zip(nodes, event['values']):
+            if value == unset:
+                continue
+            caller['nodes'][name] += held_ms
+            caller['max'][name] = max(caller['max'].get(name, value), value)
+
+    for name, caller in sorted(totals.items(), key=lambda item: -item[1]['ms']):
+        print('%s: %d locks, %.1f ms held' % (name, caller['locks'], caller['ms']))
+        for node, held_ms in sorted(caller['nodes'].items(), key=lambda item: -item[1]):
+            print('    %-24s %10.1f ms  max %d' % (node, held_ms, caller['max'][node]))
+
+
+def timeline(pid, nodes, spans, events):
+    trace = []
+
+    for start, end, event, reason in spans:
+        args = {name: value for (name, unset), value in zip(nodes, event['values'])
+                if value != unset}
+        args['handle'] = event['handle']
+        args['end'] = reason
+        if event['hint'] >= 0:
+            args['hint'] = event['hint']
+        trace.append({
+            'name': event['caller'],
+            'cat': 'perflock',
+            'ph': 'X',
+            'ts': start / 1e3,
+            'dur': (end - start) / 1e3,
+            'pid': pid,
+            'tid': event['tid'],
+            'args': args,
+        })
+
+    for event in events:
+        trace.append({
+            'name': TYPE_NAMES[event['type']],
+            'cat': 'perflock',
+            'ph': 'i',
+            's': 't',
+            'ts': event['time_ns'] / 1e3,
+            'pid': pid,
+            'tid': event['tid'],
+            'args': {'handle': event['handle'], 'duration_ms': event['duration_ms']},
+        })
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument('trace', help='file written by perf_lock_dump_trace()')
+    parser.add_argument('--json', help='write a Chrome JSON timeline to this file')
+    args = parser.parse_args()
+
+    with open(args.trace, 'rb') as f:
+        pid, nodes, events = parse(f.read())
+
+    spans = build_spans(events)
+    report(nodes, spans)
+
+    if args.json:
+        with open(args.json, 'w') as f:
+            json.dump(timeline(pid, nodes, spans, events), f)
+
+
+if __name__ == '__main__':
+    main()
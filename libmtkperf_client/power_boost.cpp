@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libmtkperf_client"
+
+#include "power_boost.h"
+
+#include <aidl/android/hardware/power/IPower.h>
+#include <aidl/google/hardware/power/extension/pixel/IPowerExt.h>
+#include <android/binder_manager.h>
+#include <log/log.h>
+
+using aidl::android::hardware::power::Boost;
+using aidl::android::hardware::power::IPower;
+using aidl::google::hardware::power::extension::pixel::IPowerExt;
+
+static std::shared_ptr<IPower> power;
+static std::shared_ptr<IPowerExt> powerExt;
+
+static bool connect() {
+    const std::string instance = std::string(IPower::descriptor) + "/default";
+    ndk::SpAIBinder binder(AServiceManager_checkService(instance.c_str()));
+    AIBinder* ext = nullptr;
+
+    power = IPower::fromBinder(binder);
+    if (!power) {
+        return false;
+    }
+
+    if (AIBinder_getExtension(binder.get(), &ext) == STATUS_OK && ext != nullptr) {
+        powerExt = IPowerExt::fromBinder(ndk::SpAIBinder(ext));
+    } else {
+        ALOGW("Power HAL has no IPowerExt, perf locks fall back to INTERACTION");
+    }
+
+    return true;
+}
+
+bool power_boost_hint(const char* hint, int duration_ms) {
+    if (!power && !connect()) {
+        return false;
+    }
+
+    ndk::ScopedAStatus status = powerExt ? powerExt->setBoost(hint, duration_ms)
+                                         : power->setBoost(Boost::INTERACTION, duration_ms);
+    if (status.isOk()) {
+        return true;
+    }
+
+    /* The HAL restarted, look it up again next time. */
+    power = nullptr;
+    powerExt = nullptr;
+    return false;
+}
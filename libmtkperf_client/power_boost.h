@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Runs the powerhint.json hint for duration_ms, through the Power HAL's
+ * IPowerExt extension. A HAL without the extension gets its INTERACTION
+ * boost instead.
+ *
+ * Never waits for the HAL to come up, returns false if it isn't there or
+ * the call failed. Only the engine thread calls this.
+ */
+bool power_boost_hint(const char *hint, int duration_ms);
+
+#ifdef __cplusplus
+}
+#endif
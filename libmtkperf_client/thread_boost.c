@@ -0,0 +1,276 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "libmtkperf_client"
+
+#include "thread_boost.h"
+
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <log/log.h>
+
+#include "node_writer.h"
+
+#ifndef SCHED_FLAG_KEEP_POLICY
+#define SCHED_FLAG_KEEP_POLICY 0x08
+#define SCHED_FLAG_KEEP_PARAMS 0x10
+#define SCHED_FLAG_UTIL_CLAMP_MIN 0x20
+#define SCHED_FLAG_UTIL_CLAMP_MAX 0x40
+#endif
+
+#define UCLAMP_FLAGS (SCHED_FLAG_KEEP_POLICY | SCHED_FLAG_KEEP_PARAMS | \
+        SCHED_FLAG_UTIL_CLAMP_MIN | SCHED_FLAG_UTIL_CLAMP_MAX)
+
+/*
+ * Kernels without uclamp get the MaxPerformance task profile from
+ * task_profiles.json instead, which is the top-app schedtune group.
+ */
+#define STUNE_ROOT "/dev/stune"
+#define STUNE_BOOST_GROUP "/top-app"
+
+/* struct sched_attr as of Linux 5.3, the first version with uclamp. */
+struct uclamp_attr {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+    uint32_t sched_util_min;
+    uint32_t sched_util_max;
+};
+
+struct boosted_thread {
+    int tid; /* 0 if the entry is free */
+    int uclamp_min;
+    int uclamp_max;
+    bool fallback;
+    /* What the thread had before we touched it. */
+    uint32_t saved_min;
+    uint32_t saved_max;
+    char saved_group[64];
+};
+
+/* Owned by the engine thread. */
+static struct boosted_thread boosted[THREAD_BOOST_MAX];
+
+static _Atomic uint64_t stat_applied;
+static _Atomic uint64_t stat_restored;
+static _Atomic uint64_t stat_failed;
+static _Atomic uint64_t stat_fallback;
+
+static int set_uclamp(int tid, uint32_t min, uint32_t max) {
+    struct uclamp_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.sched_flags = UCLAMP_FLAGS;
+    attr.sched_util_min = min;
+    attr.sched_util_max = max;
+
+    return syscall(__NR_sched_setattr, tid, &attr, 0);
+}
+
+static bool write_tid(const char *group, int tid) {
+    char path[128], value[16];
+
+    snprintf(path, sizeof(path), STUNE_ROOT "%s/tasks", strcmp(group, "/") == 0 ? "" : group);
+    snprintf(value, sizeof(value), "%d", tid);
+
+    return node_writer_write(path, value);
+}
+
+/* A thread that already sits in the boost group is neither moved nor moved back. */
+static bool in_boost_group(const struct boosted_thread *thread) {
+    return strcmp(thread->saved_group, STUNE_BOOST_GROUP) == 0;
+}
+
+/* Finds the schedtune group in /proc/<tid>/cgroup, e.g. "3:schedtune:/foreground". */
+static bool read_stune_group(int tid, char *group, size_t size) {
+    char path[64], line[128];
+    bool found = false;
+    FILE *file;
+
+    snprintf(path, sizeof(path), "/proc/%d/cgroup", tid);
+    file = fopen(path, "re");
+    if (file == NULL)
+        return false;
+
+    while (!found && fgets(line, sizeof(line), file) != NULL) {
+        char *name = strstr(line, ":schedtune:");
+
+        if (name != NULL) {
+            snprintf(group, size, "%s", name + strlen(":schedtune:"));
+            group[strcspn(group, "\n")] = '\0';
+            found = true;
+        }
+    }
+
+    fclose(file);
+    return found;
+}
+
+/*
+ * Remembers the thread's own clamps, or its schedtune group when the
+ * kernel predates uclamp and sched_getattr comes back short.
+ */
+static bool save_thread(struct boosted_thread *thread) {
+    struct uclamp_attr attr;
+
+    memset(&attr, 0, sizeof(attr));
+    if (syscall(__NR_sched_getattr, thread->tid, &attr, sizeof(attr), 0) != 0)
+        return false;
+
+    thread->fallback = attr.size < sizeof(attr);
+    if (!thread->fallback) {
+        thread->saved_min = attr.sched_util_min;
+        thread->saved_max = attr.sched_util_max;
+        return true;
+    }
+
+    return read_stune_group(thread->tid, thread->saved_group, sizeof(thread->saved_group));
+}
+
+static bool apply_thread(struct boosted_thread *thread, int min, int max) {
+    bool ok = false;
+
+    if (!thread->fallback) {
+        ok = set_uclamp(thread->tid, min, max) == 0;
+
+        /* Kernels built without uclamp know the attribute but refuse it. */
+        if (!ok && errno == EOPNOTSUPP && thread->uclamp_max < 0)
+            thread->fallback = read_stune_group(thread->tid, thread->saved_group,
+                    sizeof(thread->saved_group));
+    }
+
+    if (thread->fallback) {
+        if (in_boost_group(thread)) {
+            node_writer_skip();
+            ok = true;
+        } else {
+            ok = write_tid(STUNE_BOOST_GROUP, thread->tid);
+        }
+    }
+
+    if (!ok) {
+        ALOGW("failed to boost thread %d: %s", thread->tid, strerror(errno));
+        atomic_fetch_add_explicit(&stat_failed, 1, memory_order_relaxed);
+        return false;
+    }
+
+    thread->uclamp_min = min;
+    thread->uclamp_max = max;
+    atomic_fetch_add_explicit(thread->fallback ? &stat_fallback : &stat_applied, 1,
+            memory_order_relaxed);
+
+    return true;
+}
+
+static void restore_thread(struct boosted_thread *thread) {
+    bool ok;
+
+    if (thread->fallback && in_boost_group(thread)) {
+        node_writer_skip();
+        ok = true;
+    } else {
+        ok = thread->fallback ? write_tid(thread->saved_group, thread->tid)
+                              : set_uclamp(thread->tid, thread->saved_min, thread->saved_max) == 0;
+    }
+
+    /* A thread that exited while boosted has nothing left to restore. */
+    if (ok || errno == ESRCH)
+        atomic_fetch_add_explicit(&stat_restored, 1, memory_order_relaxed);
+    else
+        ALOGW("failed to restore thread %d: %s", thread->tid, strerror(errno));
+
+    thread->tid = 0;
+}
+
+static struct boosted_thread *find_thread(int tid) {
+    int i;
+
+    for (i = 0; i < THREAD_BOOST_MAX; i++) {
+        if (boosted[i].tid == tid)
+            return &boosted[i];
+    }
+
+    return NULL;
+}
+
+void thread_boost_update(const struct thread_boost_req reqs[], int count) {
+    struct thread_boost_req want[THREAD_BOOST_MAX];
+    struct boosted_thread *thread;
+    int wanted = 0;
+    int i, j;
+
+    for (i = 0; i < count; i++) {
+        for (j = 0; j < wanted && want[j].tid != reqs[i].tid; j++)
+            ;
+
+        if (j == wanted) {
+            want[wanted++] = reqs[i];
+            continue;
+        }
+
+        if (reqs[i].uclamp_min > want[j].uclamp_min)
+            want[j].uclamp_min = reqs[i].uclamp_min;
+        if (reqs[i].uclamp_max < want[j].uclamp_max)
+            want[j].uclamp_max = reqs[i].uclamp_max;
+    }
+
+    for (i = 0; i < THREAD_BOOST_MAX; i++) {
+        if (boosted[i].tid == 0)
+            continue;
+
+        for (j = 0; j < wanted && want[j].tid != boosted[i].tid; j++)
+            ;
+        if (j == wanted)
+            restore_thread(&boosted[i]);
+    }
+
+    for (j = 0; j < wanted; j++) {
+        thread = find_thread(want[j].tid);
+
+        if (thread == NULL) {
+            /* Every boosted thread is wanted by now, so one entry is free. */
+            thread = find_thread(0);
+            thread->tid = want[j].tid;
+            thread->uclamp_min = -1;
+            thread->uclamp_max = -1;
+
+            if (!save_thread(thread)) {
+                ALOGW("failed to read thread %d attributes: %s", thread->tid, strerror(errno));
+                atomic_fetch_add_explicit(&stat_failed, 1, memory_order_relaxed);
+                thread->tid = 0;
+                continue;
+            }
+        } else if (thread->fallback || (thread->uclamp_min == want[j].uclamp_min &&
+                thread->uclamp_max == want[j].uclamp_max)) {
+            /* schedtune has one boost level, moving again would change nothing. */
+            continue;
+        }
+
+        /* A failed first boost leaves nothing to restore. */
+        if (!apply_thread(thread, want[j].uclamp_min, want[j].uclamp_max) &&
+                thread->uclamp_max < 0)
+            thread->tid = 0;
+    }
+}
+
+void thread_boost_get_stats(struct thread_boost_stats *stats) {
+    stats->applied = atomic_load_explicit(&stat_applied, memory_order_relaxed);
+    stats->restored = atomic_load_explicit(&stat_restored, memory_order_relaxed);
+    stats->failed = atomic_load_explicit(&stat_failed, memory_order_relaxed);
+    stats->fallback = atomic_load_explicit(&stat_fallback, memory_order_relaxed);
+}
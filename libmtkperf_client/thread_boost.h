@@ -0,0 +1,39 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+/* Upper bound on the threads boosted at once, one per perf lock at most. */
+#define THREAD_BOOST_MAX 64
+
+/* Utilization clamps a lock asks for on one thread, 0..1024. */
+struct thread_boost_req {
+    int tid;
+    int uclamp_min;
+    int uclamp_max;
+};
+
+struct thread_boost_stats {
+    uint64_t applied;
+    uint64_t restored;
+    uint64_t failed;
+    /* Threads boosted through the schedtune fallback. */
+    uint64_t fallback;
+};
+
+/*
+ * Brings per-thread clamps in line with the requests of all live locks.
+ * Requests for the same tid combine to the highest minimum and lowest
+ * maximum. A thread's own attributes are saved the first time it is
+ * boosted and put back once no request names it anymore.
+ *
+ * Only called from the engine thread.
+ */
+void thread_boost_update(const struct thread_boost_req reqs[], int count);
+
+void thread_boost_get_stats(struct thread_boost_stats *stats);
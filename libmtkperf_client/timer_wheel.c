@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "timer_wheel.h"
+
+#include <string.h>
+
+#define MASK (TIMER_WHEEL_SIZE - 1)
+
+/* Ticks covered by one bucket of a level. */
+static inline int shift(int level) {
+    return level * TIMER_WHEEL_BITS;
+}
+
+static inline uint64_t rotr(uint64_t v, unsigned int n) {
+    return n ? (v >> n) | (v << (64 - n)) : v;
+}
+
+void timer_wheel_init(struct timer_wheel *w, uint64_t now) {
+    memset(w, 0, sizeof(*w));
+    memset(w->head, -1, sizeof(w->head));
+    memset(w->level, -1, sizeof(w->level));
+    w->now = now;
+}
+
+static void link_timer(struct timer_wheel *w, int id) {
+    uint64_t delta = w->expires[id] - w->now;
+    uint64_t tick = w->expires[id];
+    int level;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++) {
+        if (delta < (1ULL << shift(level + 1)))
+            break;
+    }
+
+    /* Park timers beyond the top level at its furthest bucket. */
+    if (level == TIMER_WHEEL_LEVELS - 1 &&
+            delta >= (1ULL << shift(TIMER_WHEEL_LEVELS))) {
+        tick = w->now + (1ULL << shift(TIMER_WHEEL_LEVELS)) - 1;
+    }
+
+    w->level[id] = level;
+    w->bucket[id] = (tick >> shift(level)) & MASK;
+    w->prev[id] = -1;
+    w->next[id] = w->head[level][w->bucket[id]];
+    if (w->next[id] >= 0)
+        w->prev[w->next[id]] = id;
+    w->head[level][w->bucket[id]] = id;
+    w->occupied[level] |= 1ULL << w->bucket[id];
+}
+
+void timer_wheel_del(struct timer_wheel *w, int id) {
+    int level = w->level[id];
+    int bucket = w->bucket[id];
+
+    if (level < 0)
+        return;
+
+    if (w->prev[id] >= 0)
+        w->next[w->prev[id]] = w->next[id];
+    else
+        w->head[level][bucket] = w->next[id];
+    if (w->next[id] >= 0)
+        w->prev[w->next[id]] = w->prev[id];
+
+    if (w->head[level][bucket] < 0)
+        w->occupied[level] &= ~(1ULL << bucket);
+    w->level[id] = -1;
+}
+
+void timer_wheel_add(struct timer_wheel *w, int id, uint64_t tick) {
+    timer_wheel_del(w, id);
+    w->expires[id] = tick > w->now ? tick : w->now + 1;
+    link_timer(w, id);
+}
+
+/* Empties a bucket and hands its timers to link_timer() or fn. */
+static void run_bucket(struct timer_wheel *w, int level, int bucket,
+                       timer_wheel_fn fn, void *arg) {
+    int id = w->head[level][bucket];
+
+    w->head[level][bucket] = -1;
+    w->occupied[level] &= ~(1ULL << bucket);
+
+    while (id >= 0) {
+        int next = w->next[id];
+
+        w->level[id] = -1;
+        if (w->expires[id] <= w->now)
+            fn(id, arg);
+        else
+            link_timer(w, id);
+        id = next;
+    }
+}
+
+uint64_t timer_wheel_next(const struct timer_wheel *w) {
+    uint64_t best = UINT64_MAX;
+    int level;
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+        /* The bucket after the current one is the first that can run. */
+        uint64_t base = (w->now >> shift(level)) + 1;
+        uint64_t tick;
+
+        if (!w->occupied[level])
+            continue;
+
+        tick = (base + __builtin_ctzll(rotr(w->occupied[level], base & MASK))) << shift(level);
+        if (tick < best)
+            best = tick;
+    }
+
+    return best;
+}
+
+void timer_wheel_advance(struct timer_wheel *w, uint64_t tick, timer_wheel_fn fn, void *arg) {
+    while (w->now < tick) {
+        uint64_t next = timer_wheel_next(w);
+        int level;
+
+        if (next > tick) {
+            w->now = tick;
+            break;
+        }
+        w->now = next;
+
+        /* Cascade from the top so timers can fall through several levels. */
+        for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--) {
+            if ((next & ((1ULL << shift(level)) - 1)) == 0)
+                run_bucket(w, level, (next >> shift(level)) & MASK, fn, arg);
+        }
+        run_bucket(w, 0, next & MASK, fn, arg);
+    }
+}
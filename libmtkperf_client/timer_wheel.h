@@ -0,0 +1,49 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_LEVELS  3
+#define TIMER_WHEEL_BITS    6
+#define TIMER_WHEEL_SIZE    (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MAX_IDS 64
+
+/*
+ * Hierarchical timer wheel for up to TIMER_WHEEL_MAX_IDS timers identified
+ * by small integers. Level 0 has one bucket per tick, every higher level
+ * one bucket per full turn of the level below, and timers cascade down as
+ * their bucket comes up. Timers further out than the top level reaches
+ * are parked in it and placed again when they cascade.
+ *
+ * Not thread safe, meant to be owned by a single thread.
+ */
+struct timer_wheel {
+    uint64_t now;
+    uint64_t occupied[TIMER_WHEEL_LEVELS];
+    int8_t head[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SIZE];
+    int8_t next[TIMER_WHEEL_MAX_IDS];
+    int8_t prev[TIMER_WHEEL_MAX_IDS];
+    int8_t level[TIMER_WHEEL_MAX_IDS];
+    uint8_t bucket[TIMER_WHEEL_MAX_IDS];
+    uint64_t expires[TIMER_WHEEL_MAX_IDS];
+};
+
+typedef void (*timer_wheel_fn)(int id, void *arg);
+
+void timer_wheel_init(struct timer_wheel *w, uint64_t now);
+
+/* (Re)arms id to fire at tick, ticks that already passed fire next tick. */
+void timer_wheel_add(struct timer_wheel *w, int id, uint64_t tick);
+
+void timer_wheel_del(struct timer_wheel *w, int id);
+
+/* Moves the wheel to tick, calling fn for every timer that fired. */
+void timer_wheel_advance(struct timer_wheel *w, uint64_t tick, timer_wheel_fn fn, void *arg);
+
+/* First tick at which advancing does any work, UINT64_MAX if idle. */
+uint64_t timer_wheel_next(const struct timer_wheel *w);
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "BacklightWriter.h"
+
+#include <android-base/logging.h>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+BacklightWriter::BacklightWriter(LevelFn level, ApplyFn apply, std::chrono::nanoseconds period,
+                                 bool kernelRamp, LightStats& stats)
+    : mLevel(std::move(level)),
+      mApply(std::move(apply)),
+      mPeriod(period),
+      mKernelRamp(kernelRamp),
+      mStats(stats),
+      mSlot(kEmpty),
+      mStop(false),
+      mEventFd(eventfd(0, EFD_CLOEXEC)),
+      mTimerFd(timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC)),
+      mCurrent(UINT32_MAX),
+      mRampFrom(0),
+      mRampTo(0),
+      mRampDuration(0),
+      mRamping(false) {
+    if (mEventFd < 0 || mTimerFd < 0) {
+        PLOG(ERROR) << "failed to create backlight writer fds";
+    }
+
+    mThread = std::thread(&BacklightWriter::threadLoop, this);
+}
+
+BacklightWriter::~BacklightWriter() {
+    mStop = true;
+    eventfd_write(mEventFd, 1);
+    mThread.join();
+}
+
+void BacklightWriter::post(uint32_t color, uint32_t rampMs) {
+    /*
+     * The ramp duration rides in the upper half with its top bit clear, so
+     * a posted value can never collide with kEmpty.
+     */
+    uint64_t value = (uint64_t(rampMs & 0x7FFFFFFF) << 32) | color;
+
+    /*
+     * Only the transition from an empty slot needs a wakeup, a color that
+     * replaces a pending one is picked up by the same wakeup.
+     */
+    if (mSlot.exchange(value, std::memory_order_acq_rel) == kEmpty) {
+        eventfd_write(mEventFd, 1);
+    } else {
+        mStats.recordCoalesced();
+    }
+}
+
+void BacklightWriter::startRamp(uint32_t target, uint32_t rampMs) {
+    auto nsec = [](std::chrono::nanoseconds ns) {
+        return timespec{time_t(duration_cast<seconds>(ns).count()), long(ns.count() % 1000000000)};
+    };
+    itimerspec spec = {nsec(mPeriod), nsec(mPeriod)};
+
+    mRampFrom = mCurrent;
+    mRampTo = target;
+    mRampStart = steady_clock::now();
+    mRampDuration = milliseconds(rampMs);
+    mRamping = true;
+
+    if (timerfd_settime(mTimerFd, 0, &spec, nullptr) != 0) {
+        PLOG(ERROR) << "failed to arm backlight ramp timer";
+        stopRamp();
+        mApply(target, 0);
+        mCurrent = target;
+    }
+}
+
+void BacklightWriter::stepRamp() {
+    auto elapsed = duration_cast<milliseconds>(steady_clock::now() - mRampStart);
+    uint32_t level = mRampTo;
+
+    if (elapsed < mRampDuration) {
+        int64_t delta = int64_t(mRampTo) - int64_t(mRampFrom);
+        level = uint32_t(int64_t(mRampFrom) + delta * elapsed.count() / mRampDuration.count());
+    } else {
+        stopRamp();
+    }
+
+    if (level != mCurrent) {
+        mApply(level, 0);
+        mCurrent = level;
+    }
+}
+
+void BacklightWriter::stopRamp() {
+    itimerspec spec = {};
+
+    timerfd_settime(mTimerFd, 0, &spec, nullptr);
+    mRamping = false;
+}
+
+void BacklightWriter::threadLoop() {
+    uint64_t last = kEmpty;
+    pollfd fds[] = {
+        {mEventFd, POLLIN, 0},
+        {mTimerFd, POLLIN, 0},
+    };
+
+    while (!mStop) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            PLOG(ERROR) << "failed to wait for backlight updates";
+            return;
+        }
+
+        if (fds[1].revents & POLLIN) {
+            uint64_t expirations;
+            if (read(mTimerFd, &expirations, sizeof(expirations)) > 0 && mRamping) {
+                stepRamp();
+            }
+        }
+
+        if (!(fds[0].revents & POLLIN)) {
+            continue;
+        }
+
+        eventfd_t unused;
+        eventfd_read(mEventFd, &unused);
+
+        uint64_t value = mSlot.exchange(kEmpty, std::memory_order_acq_rel);
+        if (value == kEmpty) {
+            continue;
+        }
+        if (value == last) {
+            mStats.recordDropped();
+            continue;
+        }
+        last = value;
+
+        uint32_t target = mLevel(uint32_t(value));
+        uint32_t rampMs = uint32_t(value >> 32);
+
+        if (mRamping) {
+            stopRamp();
+        }
+
+        if (rampMs > 0 && mCurrent != UINT32_MAX && target != mCurrent && !mKernelRamp) {
+            startRamp(target, rampMs);
+            continue;
+        }
+
+        mApply(target, rampMs);
+        mCurrent = target;
+
+        /*
+         * Anything posted while we sleep lands in the slot and is coalesced
+         * into a single write on the next iteration.
+         */
+        std::this_thread::sleep_for(mPeriod);
+    }
+}
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
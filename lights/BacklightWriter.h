@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+#include "LightStats.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+/*
+ * Applies backlight colors from a dedicated thread.
+ *
+ * post() only swaps the color into a single-slot mailbox and returns, so
+ * binder threads never wait on sysfs. The writer thread applies the newest
+ * color it finds, skips colors equal to the last one written and never
+ * writes more often than once per period; intermediate colors posted in
+ * between are coalesced.
+ *
+ * A color posted with a ramp duration is faded to from the current level.
+ * If the kernel can ramp by itself the target is handed over in one write,
+ * otherwise a timerfd steps the level once per period. A newer post cancels
+ * a running ramp and starts from wherever it got to.
+ */
+class BacklightWriter {
+  public:
+    using LevelFn = std::function<uint32_t(uint32_t color)>;
+    using ApplyFn = std::function<void(uint32_t level, uint32_t rampMs)>;
+
+    BacklightWriter(LevelFn level, ApplyFn apply, std::chrono::nanoseconds period,
+                    bool kernelRamp, LightStats& stats);
+    ~BacklightWriter();
+
+    void post(uint32_t color, uint32_t rampMs = 0);
+
+  private:
+    static constexpr uint64_t kEmpty = UINT64_MAX;
+
+    void threadLoop();
+    void startRamp(uint32_t target, uint32_t rampMs);
+    void stepRamp();
+    void stopRamp();
+
+    LevelFn mLevel;
+    ApplyFn mApply;
+    std::chrono::nanoseconds mPeriod;
+    bool mKernelRamp;
+    LightStats& mStats;
+    std::atomic<uint64_t> mSlot;
+    std::atomic<bool> mStop;
+    ::android::base::unique_fd mEventFd;
+    ::android::base::unique_fd mTimerFd;
+    std::thread mThread;
+
+    /* Only touched by the writer thread. */
+    uint32_t mCurrent;
+    uint32_t mRampFrom;
+    uint32_t mRampTo;
+    std::chrono::steady_clock::time_point mRampStart;
+    std::chrono::milliseconds mRampDuration;
+    bool mRamping;
+};
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "BacklightWriter.h"
+#include "BrightnessTable.h"
+#include "LedDevice.h"
+#include "LightStats.h"
+
+#include <android-base/file.h>
+#include <benchmark/benchmark.h>
+
+#include <sys/stat.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+namespace {
+
+using std::chrono::microseconds;
+using std::chrono::steady_clock;
+
+/*
+ * A backlight LED under a temporary directory. The panel driver takes a
+ * while to apply a level, which is modelled as a sleep after every write.
+ */
+class FakeBacklight {
+  public:
+    explicit FakeBacklight(const benchmark::State& state)
+        : mLatency(state.range(0)), mLed(mDir.path, "lcd-backlight"), mTable("/nonexistent") {
+        std::string node = std::string(mDir.path) + "/lcd-backlight";
+
+        mkdir(node.c_str(), 0700);
+        ::android::base::WriteStringToFile("2047", node + "/max_brightness");
+        ::android::base::WriteStringToFile("0", node + "/brightness");
+    }
+
+    uint32_t level(uint32_t color) { return mTable.lookup(color & 0xFF, mLed.maxBrightness()); }
+
+    void apply(uint32_t level) {
+        auto start = steady_clock::now();
+        bool ok = mLed.setBrightness(level);
+
+        if (mLatency.count() > 0) {
+            std::this_thread::sleep_for(mLatency);
+        }
+        mStats.recordWrite(steady_clock::now() - start, ok);
+        mWrites++;
+    }
+
+    LightStats& stats() { return mStats; }
+
+    void report(benchmark::State& state) {
+        state.counters["writes/call"] =
+                benchmark::Counter(mWrites, benchmark::Counter::kAvgIterations);
+    }
+
+  private:
+    TemporaryDir mDir;
+    microseconds mLatency;
+    LedDevice mLed;
+    BrightnessTable mTable;
+    LightStats mStats;
+    std::atomic<uint64_t> mWrites{0};
+};
+
+/* An animation: every call carries a new level, as the framework sends them. */
+uint32_t nextColor(uint32_t& luma) {
+    luma = luma % 0xFF + 1;
+    return 0xFF000000 | luma * 0x010101;
+}
+
+/* setLightState() with the writer disabled, the binder thread writes sysfs. */
+void BM_SyncBacklight(benchmark::State& state) {
+    FakeBacklight backlight(state);
+    uint32_t luma = 0;
+
+    for (auto _ : state) {
+        backlight.apply(backlight.level(nextColor(luma)));
+    }
+
+    backlight.report(state);
+}
+BENCHMARK(BM_SyncBacklight)->Arg(0)->Arg(100)->UseRealTime();
+
+/* setLightState() with the writer at 60 Hz, the binder thread only posts. */
+void BM_AsyncBacklight(benchmark::State& state) {
+    FakeBacklight backlight(state);
+    uint32_t luma = 0;
+
+    {
+        BacklightWriter writer([&](uint32_t color) { return backlight.level(color); },
+                               [&](uint32_t level, uint32_t) { backlight.apply(level); },
+                               std::chrono::nanoseconds(std::chrono::seconds(1)) / 60, false,
+                               backlight.stats());
+
+        for (auto _ : state) {
+            writer.post(nextColor(luma));
+        }
+    }
+
+    backlight.report(state);
+}
+BENCHMARK(BM_AsyncBacklight)->Arg(0)->Arg(100)->UseRealTime();
+
+/* The same with a repeated color, duplicates never reach sysfs. */
+void BM_AsyncBacklightDuplicates(benchmark::State& state) {
+    FakeBacklight backlight(state);
+
+    {
+        BacklightWriter writer([&](uint32_t color) { return backlight.level(color); },
+                               [&](uint32_t level, uint32_t) { backlight.apply(level); },
+                               std::chrono::nanoseconds(std::chrono::seconds(1)) / 60, false,
+                               backlight.stats());
+
+        for (auto _ : state) {
+            writer.post(0xFF808080);
+        }
+    }
+
+    backlight.report(state);
+}
+BENCHMARK(BM_AsyncBacklightDuplicates)->Arg(0)->UseRealTime();
+
+}  // anonymous namespace
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+BENCHMARK_MAIN();
@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "BrightnessTable.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+/* Lowest level the panel still lights up at. */
+#define MIN_LEVEL 19
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+BrightnessTable::BrightnessTable(const std::string& curvePath)
+    : mGamma(0), mMaxBrightness(UINT32_MAX), mLevels{} {
+    std::string content;
+
+    if (!::android::base::ReadFileToString(curvePath, &content)) {
+        return;
+    }
+
+    for (const auto& rawLine : ::android::base::Split(content, "\n")) {
+        std::string line = ::android::base::Trim(rawLine);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        std::vector<std::string> fields = ::android::base::Split(line, " ");
+        uint32_t luma, permille;
+
+        if (fields.size() == 2 && fields[0] == "gamma") {
+            mGamma = strtof(fields[1].c_str(), nullptr);
+        } else if (fields.size() == 2 &&
+                   ::android::base::ParseUint(fields[0], &luma, 255u) &&
+                   ::android::base::ParseUint(fields[1], &permille, 1000u)) {
+            mPoints.emplace_back(luma, permille);
+        } else {
+            LOG(WARNING) << "ignoring malformed line in " << curvePath << ": " << line;
+        }
+    }
+
+    if (mGamma <= 0 && mPoints.empty()) {
+        LOG(WARNING) << "no usable curve in " << curvePath << ", using linear scaling";
+        mGamma = 0;
+        return;
+    }
+
+    std::sort(mPoints.begin(), mPoints.end());
+    LOG(INFO) << "loaded backlight curve from " << curvePath;
+}
+
+uint32_t BrightnessTable::curveLevel(uint32_t luma, uint32_t maxBrightness) const {
+    if (luma == 0) {
+        return 0;
+    }
+
+    if (mGamma > 0) {
+        float x = (luma - 1) / float(0xFF - 1);
+        return std::lround(std::pow(x, mGamma) * (maxBrightness - MIN_LEVEL)) + MIN_LEVEL;
+    }
+
+    if (!mPoints.empty()) {
+        int32_t permille;
+        auto hi = std::lower_bound(mPoints.begin(), mPoints.end(), std::make_pair(luma, 0u));
+
+        if (hi == mPoints.begin()) {
+            permille = hi->second;
+        } else if (hi == mPoints.end()) {
+            permille = mPoints.back().second;
+        } else {
+            auto lo = hi - 1;
+            permille = int32_t(lo->second) + (int32_t(hi->second) - int32_t(lo->second)) *
+                                                     int32_t(luma - lo->first) /
+                                                     int32_t(hi->first - lo->first);
+        }
+
+        return std::max<uint32_t>(permille * maxBrightness / 1000, MIN_LEVEL);
+    }
+
+    return (luma - 1) * (maxBrightness - MIN_LEVEL) / (0xFF - 1) + MIN_LEVEL;
+}
+
+void BrightnessTable::build(uint32_t maxBrightness) {
+    for (uint32_t luma = 0; luma < mLevels.size(); luma++) {
+        mLevels[luma] = curveLevel(luma, maxBrightness);
+    }
+
+    mMaxBrightness = maxBrightness;
+}
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
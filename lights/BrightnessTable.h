@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+/*
+ * Maps an 8-bit luma value to a backlight level.
+ *
+ * The table is rebuilt only when max_brightness changes. By default it
+ * reproduces the linear scaling the HAL always used, a curve file may
+ * replace it with a gamma curve or panel calibration points:
+ *
+ *   gamma 2.2
+ *
+ * or one "<luma> <per-mille of max_brightness>" pair per line, which is
+ * linearly interpolated.
+ */
+class BrightnessTable {
+  public:
+    explicit BrightnessTable(const std::string& curvePath);
+
+    uint32_t lookup(uint32_t luma, uint32_t maxBrightness) {
+        if (maxBrightness != mMaxBrightness) {
+            build(maxBrightness);
+        }
+        return mLevels[luma & 0xFF];
+    }
+
+  private:
+    void build(uint32_t maxBrightness);
+    uint32_t curveLevel(uint32_t luma, uint32_t maxBrightness) const;
+
+    float mGamma;
+    std::vector<std::pair<uint32_t, uint32_t>> mPoints;
+    uint32_t mMaxBrightness;
+    std::array<uint32_t, 256> mLevels;
+};
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "BrightnessTable.h"
+
+#include <benchmark/benchmark.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+namespace {
+
+/* The per-call rescale the table replaced. */
+uint32_t scaleBrightness(uint32_t brightness, uint32_t maxBrightness) {
+    if (brightness == 0) {
+        return 0;
+    }
+
+    return (brightness - 1) * (maxBrightness - 19) / (0xFF - 1) + 19;
+}
+
+/* max_brightness is read from sysfs, keep the compiler from folding it. */
+uint32_t maxBrightness(const benchmark::State& state) {
+    uint32_t max = state.range(0);
+
+    benchmark::DoNotOptimize(max);
+    return max;
+}
+
+/* Each pass maps the full luma range once. */
+void BM_ScaleBrightness(benchmark::State& state) {
+    uint32_t max = maxBrightness(state);
+
+    for (auto _ : state) {
+        for (uint32_t luma = 0; luma <= 0xFF; luma++) {
+            benchmark::DoNotOptimize(scaleBrightness(luma, max));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_ScaleBrightness)->Arg(255)->Arg(2047);
+
+void BM_TableLookup(benchmark::State& state) {
+    BrightnessTable table("/nonexistent");
+    uint32_t max = maxBrightness(state);
+
+    for (auto _ : state) {
+        for (uint32_t luma = 0; luma <= 0xFF; luma++) {
+            benchmark::DoNotOptimize(table.lookup(luma, max));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 256);
+}
+BENCHMARK(BM_TableLookup)->Arg(255)->Arg(2047);
+
+/* What a max_brightness change costs, the table is rebuilt once. */
+void BM_TableRebuild(benchmark::State& state) {
+    BrightnessTable table("/nonexistent");
+    uint32_t max = maxBrightness(state);
+    bool flip = false;
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(table.lookup(0xFF, flip ? max : max - 1));
+        flip = !flip;
+    }
+}
+BENCHMARK(BM_TableRebuild)->Arg(2047);
+
+}  // anonymous namespace
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
+
+BENCHMARK_MAIN();
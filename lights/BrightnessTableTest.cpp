@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "BrightnessTable.h"
+
+#include <android-base/file.h>
+#include <gtest/gtest.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+namespace {
+
+/* The per-call rescale the table replaced. */
+uint32_t scaleBrightness(uint32_t brightness, uint32_t maxBrightness) {
+    if (brightness == 0) {
+        return 0;
+    }
+
+    return (brightness - 1) * (maxBrightness - 19) / (0xFF - 1) + 19;
+}
+
+BrightnessTable tableFromCurve(const std::string& curve) {
+    TemporaryFile file;
+
+    EXPECT_TRUE(::android::base::WriteStringToFile(curve, file.path));
+    return BrightnessTable(file.path);
+}
+
+}  // anonymous namespace
+
+TEST(BrightnessTableTest, LinearMatchesOldMathEverywhere) {
+    BrightnessTable table("/nonexistent");
+
+    /* Every luma for every max_brightness the panel can light up with. */
+    for (uint32_t maxBrightness = 19; maxBrightness <= 0xFFFF; maxBrightness++) {
+        for (uint32_t luma = 0; luma <= 0xFF; luma++) {
+            ASSERT_EQ(table.lookup(luma, maxBrightness), scaleBrightness(luma, maxBrightness))
+                    << "luma " << luma << " max " << maxBrightness;
+        }
+    }
+}
+
+TEST(BrightnessTableTest, RebuildsOnMaxChange) {
+    BrightnessTable table("/nonexistent");
+
+    EXPECT_EQ(table.lookup(255, 2047), 2047u);
+    EXPECT_EQ(table.lookup(255, 255), 255u);
+    EXPECT_EQ(table.lookup(128, 2047), scaleBrightness(128, 2047));
+}
+
+TEST(BrightnessTableTest, GammaCurve) {
+    BrightnessTable table = tableFromCurve("gamma 2.2\n");
+
+    EXPECT_EQ(table.lookup(0, 2047), 0u);
+    EXPECT_EQ(table.lookup(1, 2047), 19u);
+    EXPECT_EQ(table.lookup(255, 2047), 2047u);
+    /* Below the linear level in the middle, and still increasing. */
+    EXPECT_LT(table.lookup(128, 2047), scaleBrightness(128, 2047));
+    for (uint32_t luma = 1; luma < 0xFF; luma++) {
+        EXPECT_LE(table.lookup(luma, 2047), table.lookup(luma + 1, 2047));
+    }
+}
+
+TEST(BrightnessTableTest, CalibrationPoints) {
+    BrightnessTable table = tableFromCurve(
+            "# luma per-mille\n"
+            "255 1000\n"
+            "1 10\n"
+            "128 250\n");
+
+    EXPECT_EQ(table.lookup(0, 2000), 0u);
+    EXPECT_EQ(table.lookup(1, 2000), 20u);
+    EXPECT_EQ(table.lookup(128, 2000), 500u);
+    EXPECT_EQ(table.lookup(255, 2000), 2000u);
+    /* Halfway between 128 and 255, interpolated. */
+    EXPECT_EQ(table.lookup(191, 2000), 2000 * (250 + 750 * 63 / 127) / 1000);
+    /* Points below the panel's lowest level are raised to it. */
+    EXPECT_EQ(table.lookup(1, 1000), 19u);
+}
+
+TEST(BrightnessTableTest, MalformedCurveFallsBackToLinear) {
+    BrightnessTable table = tableFromCurve("gamma\n300 2000\nfoo bar baz\n");
+
+    for (uint32_t luma = 0; luma <= 0xFF; luma++) {
+        EXPECT_EQ(table.lookup(luma, 2047), scaleBrightness(luma, 2047));
+    }
+}
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
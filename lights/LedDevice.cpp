@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "LedDevice.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/strings.h>
+
+#include <charconv>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define BRIGHTNESS      "brightness"
+#define MAX_BRIGHTNESS  "max_brightness"
+#define TRIGGER         "trigger"
+#define DELAY_ON        "delay_on"
+#define DELAY_OFF       "delay_off"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+LedDevice::LedDevice(const std::string& root, const std::string& name)
+    : mName(name), mPath(root + "/" + name + "/"), mMaxBrightness(0), mBlinking(false) {}
+
+bool LedDevice::exists() const {
+    return hasAttr(BRIGHTNESS);
+}
+
+bool LedDevice::hasAttr(const std::string& attr) const {
+    return access((mPath + attr).c_str(), F_OK) == 0;
+}
+
+bool LedDevice::open() {
+    std::string value;
+
+    if (!::android::base::ReadFileToString(mPath + MAX_BRIGHTNESS, &value) ||
+        !::android::base::ParseUint(::android::base::Trim(value), &mMaxBrightness)) {
+        LOG(WARNING) << "failed to read from " << mPath << MAX_BRIGHTNESS;
+        mMaxBrightness = 0;
+    }
+
+    mFd.reset(TEMP_FAILURE_RETRY(::open((mPath + BRIGHTNESS).c_str(), O_WRONLY | O_CLOEXEC)));
+    if (mFd < 0) {
+        PLOG(WARNING) << "failed to open " << mPath << BRIGHTNESS;
+        return false;
+    }
+
+    return true;
+}
+
+void LedDevice::close() {
+    mFd.reset();
+}
+
+uint32_t LedDevice::maxBrightness() {
+    if (mFd < 0) {
+        open();
+    }
+
+    return mMaxBrightness;
+}
+
+bool LedDevice::writeAttr(const std::string& attr, const std::string& value) {
+    if (!::android::base::WriteStringToFile(value, mPath + attr)) {
+        PLOG(WARNING) << "failed to write " << value << " to " << mPath << attr;
+        return false;
+    }
+
+    return true;
+}
+
+bool LedDevice::setBlink(uint32_t value, uint32_t onMs, uint32_t offMs) {
+    /*
+     * The timer trigger blinks at the brightness set before it is armed, and
+     * writing brightness 0 afterwards would disarm it again.
+     */
+    if (!setBrightness(value) || value == 0) {
+        return false;
+    }
+
+    mBlinking = writeAttr(TRIGGER, "timer") &&
+                writeAttr(DELAY_ON, std::to_string(onMs)) &&
+                writeAttr(DELAY_OFF, std::to_string(offMs));
+
+    return mBlinking;
+}
+
+bool LedDevice::setBrightness(uint32_t value) {
+    char buf[16];
+
+    if (mBlinking) {
+        writeAttr(TRIGGER, "none");
+        mBlinking = false;
+    }
+
+    if (mFd < 0 && !open()) {
+        return false;
+    }
+
+    auto [end, ec] = std::to_chars(buf, buf + sizeof(buf) - 1, value);
+    *end++ = '\n';
+
+    ssize_t len = end - buf;
+    if (TEMP_FAILURE_RETRY(pwrite(mFd, buf, len, 0)) != len) {
+        PLOG(WARNING) << "failed to write " << value << " to " << mPath << BRIGHTNESS;
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
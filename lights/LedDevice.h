@@ -0,0 +1,55 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+/*
+ * A single /sys/class/leds/<name> node.
+ *
+ * max_brightness is read once and the brightness node is kept open, so a
+ * brightness update costs a single pwrite(). The node is reopened (and
+ * max_brightness re-read) only after a failed write.
+ *
+ * Blinking is left to the kernel timer trigger, so no userspace thread has
+ * to wake up to toggle the LED.
+ */
+class LedDevice {
+  public:
+    LedDevice(const std::string& root, const std::string& name);
+
+    const std::string& name() const { return mName; }
+    bool exists() const;
+    bool hasAttr(const std::string& attr) const;
+
+    uint32_t maxBrightness();
+    bool setBrightness(uint32_t value);
+    bool setBlink(uint32_t value, uint32_t onMs, uint32_t offMs);
+    bool writeAttr(const std::string& attr, const std::string& value);
+
+  private:
+    bool open();
+    void close();
+
+    std::string mName;
+    std::string mPath;
+    ::android::base::unique_fd mFd;
+    uint32_t mMaxBrightness;
+    bool mBlinking;
+};
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
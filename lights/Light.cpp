@@ -6,60 +6,34 @@
 
 #include "Light.h"
 
+#include <android-base/file.h>
 #include <android-base/properties.h>
 
-#include <fstream>
+#include <algorithm>
+#include <map>
 
-#define LCD_LED         "/sys/class/leds/lcd-backlight/"
+#define LCD_LED         "lcd-backlight"
 
-#define BRIGHTNESS      "brightness"
-#define MAX_BRIGHTNESS  "max_brightness"
+#define BACKLIGHT_CURVE "/vendor/etc/backlight_curve.conf"
 
-namespace {
-/*
- * Write value to path and close file.
- */
-static void set(std::string path, std::string value) {
-    std::ofstream file(path);
-
-    if (!file.is_open()) {
-        LOG(WARNING) << "failed to write " << value.c_str() << " to " << path.c_str();
-        return;
-    }
-
-    file << value;
-}
-
-static void set(std::string path, int value) {
-    set(path, std::to_string(value));
-}
-
-/*
- * Read max brightness from path and close file.
- */
-static int getMaxBrightness(std::string path) {
-    std::ifstream file(path);
-    int value;
+#define ASYNC_BACKLIGHT_PROP    "ro.vendor.light.async_backlight"
+#define BACKLIGHT_RATE_PROP     "ro.vendor.light.backlight_rate_hz"
+#define BACKLIGHT_RAMP_PROP     "ro.vendor.light.backlight_ramp_ms"
+#define BACKLIGHT_RAMP_ATTR_PROP "ro.vendor.light.backlight_ramp_attr"
+#define BACKLIGHT_ON_PROP       "vendor.light.backlight_on"
 
-    if (!file.is_open()) {
-        LOG(WARNING) << "failed to read from " << path.c_str();
-        return 0;
-    }
-
-    file >> value;
-    return value;
-}
+namespace {
 
-static uint32_t getBrightness(const HwLightState& state) {
+static uint32_t getBrightness(uint32_t color) {
     uint32_t alpha, red, green, blue;
 
     /*
      * Extract brightness from AARRGGBB.
      */
-    alpha = (state.color >> 24) & 0xFF;
-    red = (state.color >> 16) & 0xFF;
-    green = (state.color >> 8) & 0xFF;
-    blue = state.color & 0xFF;
+    alpha = (color >> 24) & 0xFF;
+    red = (color >> 16) & 0xFF;
+    green = (color >> 8) & 0xFF;
+    blue = color & 0xFF;
 
     /*
      * Scale RGB brightness using Alpha brightness.
@@ -71,26 +45,33 @@ static uint32_t getBrightness(const HwLightState& state) {
     return (77 * red + 150 * green + 29 * blue) >> 8;
 }
 
-static inline uint32_t scaleBrightness(uint32_t brightness, uint32_t maxBrightness) {
-    if (brightness == 0) {
-        return 0;
-    }
-
-    return (brightness - 1) * (maxBrightness - 19) / (0xFF - 1) + 19;
+static inline uint32_t getChannel(uint32_t color, int shift) {
+    return ((color >> shift) & 0xFF) * ((color >> 24) & 0xFF) / 0xFF;
 }
 
-static inline uint32_t getScaledBrightness(const HwLightState& state, uint32_t maxBrightness) {
-    return scaleBrightness(getBrightness(state), maxBrightness);
-}
-
-static void handleBacklight(const HwLightState& state) {
-    uint32_t brightness = getScaledBrightness(state, getMaxBrightness(LCD_LED MAX_BRIGHTNESS));
-    set(LCD_LED BRIGHTNESS, brightness);
+static inline bool isLit(const HwLightState& state) {
+    return (state.color & 0xFFFFFF) != 0;
 }
 
 /* Keep sorted in the order of importance. */
 static std::vector<LightType> backends = {
     LightType::BACKLIGHT,
+    LightType::ATTENTION,
+    LightType::NOTIFICATIONS,
+    LightType::BATTERY,
+    LightType::BUTTONS,
+};
+
+/*
+ * LED sets each light type can drive, the first set fully present under the
+ * leds root is used. A set of three is driven as red, green and blue.
+ * Types that end up on the same set share it in the order of importance.
+ */
+static const std::map<LightType, std::vector<std::vector<std::string>>> ledNames = {
+    {LightType::ATTENTION, {{"red", "green", "blue"}, {"white"}}},
+    {LightType::NOTIFICATIONS, {{"red", "green", "blue"}, {"white"}}},
+    {LightType::BATTERY, {{"red", "green", "blue"}, {"white"}}},
+    {LightType::BUTTONS, {{"button-backlight"}}},
 };
 
 }  // anonymous namespace
@@ -100,20 +81,184 @@ namespace android{
 namespace hardware {
 namespace light {
 
+Lights::Lights(const std::string& root)
+    : mBacklight(root, LCD_LED),
+      mBacklightTable(BACKLIGHT_CURVE),
+      mBacklightRampMs(::android::base::GetUintProperty<uint32_t>(BACKLIGHT_RAMP_PROP, 0, 10000)),
+      mBacklightRampAttr(::android::base::GetProperty(BACKLIGHT_RAMP_ATTR_PROP, "")),
+      mBacklightKernelRampMs(UINT32_MAX),
+      mBacklightOn(-1) {
+    if (!mBacklightRampAttr.empty() && !mBacklight.hasAttr(mBacklightRampAttr)) {
+        LOG(WARNING) << "backlight has no " << mBacklightRampAttr << ", ramping in userspace";
+        mBacklightRampAttr.clear();
+    }
+
+    /*
+     * Ramping in userspace needs the writer thread, so a default ramp
+     * implies asynchronous updates.
+     */
+    if (::android::base::GetBoolProperty(ASYNC_BACKLIGHT_PROP, false) || mBacklightRampMs > 0) {
+        uint32_t rate = ::android::base::GetUintProperty<uint32_t>(BACKLIGHT_RATE_PROP, 60, 1000);
+
+        mBacklightWriter = std::make_unique<BacklightWriter>(
+                [this](uint32_t color) { return getBacklightLevel(color); },
+                [this](uint32_t level, uint32_t rampMs) { setBacklightLevel(level, rampMs); },
+                std::chrono::nanoseconds(std::chrono::seconds(1)) / std::max(rate, 1u),
+                !mBacklightRampAttr.empty(), stats(LightType::BACKLIGHT));
+    }
+
+    for (const LightType& backend : backends) {
+        auto it = ledNames.find(backend);
+        if (it == ledNames.end()) {
+            continue;
+        }
+
+        for (const auto& names : it->second) {
+            std::vector<LedDevice*> leds;
+
+            for (const auto& name : names) {
+                LedDevice* led = getLed(root, name);
+                if (led == nullptr) {
+                    break;
+                }
+                leds.push_back(led);
+            }
+
+            if (leds.size() == names.size()) {
+                mIndicators.push_back({backend, leds, HwLightState()});
+                break;
+            }
+        }
+    }
+}
+
+LedDevice* Lights::getLed(const std::string& root, const std::string& name) {
+    auto it = mLeds.find(name);
+    if (it != mLeds.end()) {
+        return it->second.get();
+    }
+
+    auto led = std::make_unique<LedDevice>(root, name);
+    if (!led->exists()) {
+        return nullptr;
+    }
+
+    LOG(INFO) << "found led " << name;
+    return mLeds.emplace(name, std::move(led)).first->second.get();
+}
+
+uint32_t Lights::getBacklightLevel(uint32_t color) {
+    return mBacklightTable.lookup(getBrightness(color), mBacklight.maxBrightness());
+}
+
+void Lights::setBacklightLevel(uint32_t level, uint32_t rampMs) {
+    if (!mBacklightRampAttr.empty() && rampMs != mBacklightKernelRampMs) {
+        mBacklight.writeAttr(mBacklightRampAttr, std::to_string(rampMs));
+        mBacklightKernelRampMs = rampMs;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool ok = mBacklight.setBrightness(level);
+    stats(LightType::BACKLIGHT).recordWrite(std::chrono::steady_clock::now() - start, ok);
+
+    /*
+     * Let other HALs follow the panel without polling sysfs, only the
+     * on/off transitions are published.
+     */
+    int on = level > 0;
+    if (ok && on != mBacklightOn) {
+        ::android::base::SetProperty(BACKLIGHT_ON_PROP, on ? "1" : "0");
+        mBacklightOn = on;
+    }
+}
+
+void Lights::handleBacklight(const HwLightState& state) {
+    /*
+     * The framework never flashes the backlight, so a timed flash carries
+     * the duration to ramp to this level over instead.
+     */
+    uint32_t rampMs = state.flashMode == FlashMode::TIMED ? uint32_t(std::max(state.flashOnMs, 0))
+                                                          : mBacklightRampMs;
+
+    if (mBacklightWriter) {
+        mBacklightWriter->post(state.color, rampMs);
+    } else {
+        setBacklightLevel(getBacklightLevel(state.color), 0);
+    }
+}
+
+void Lights::applyIndicator(const std::vector<LedDevice*>& leds, const HwLightState& state,
+                            LightStats& stats) {
+    uint32_t color = state.color;
+    bool blink = state.flashMode != FlashMode::NONE && state.flashOnMs > 0 && state.flashOffMs > 0;
+
+    /* Treat a fully transparent color as opaque, as the framework does. */
+    if ((color >> 24) == 0) {
+        color |= 0xFF000000;
+    }
+
+    for (size_t i = 0; i < leds.size(); i++) {
+        uint32_t value = leds.size() == 3 ? getChannel(color, 16 - 8 * i) : getBrightness(color);
+        value = value * leds[i]->maxBrightness() / 0xFF;
+
+        auto start = std::chrono::steady_clock::now();
+        bool ok = blink ? leds[i]->setBlink(value, state.flashOnMs, state.flashOffMs) || value == 0
+                        : leds[i]->setBrightness(value);
+        stats.recordWrite(std::chrono::steady_clock::now() - start, ok);
+    }
+}
+
+void Lights::handleIndicator(Indicator& indicator, const HwLightState& state) {
+    indicator.state = state;
+
+    /*
+     * mIndicators is sorted in the order of importance, so the first lit
+     * indicator sharing these LEDs owns them.
+     */
+    for (const auto& other : mIndicators) {
+        if (other.leds == indicator.leds && isLit(other.state)) {
+            applyIndicator(other.leds, other.state, stats(indicator.type));
+            return;
+        }
+    }
+
+    applyIndicator(indicator.leds, HwLightState(), stats(indicator.type));
+}
+
+bool Lights::isAvailable(LightType type) const {
+    return type == LightType::BACKLIGHT ||
+           std::any_of(mIndicators.begin(), mIndicators.end(),
+                       [&](const Indicator& indicator) { return indicator.type == type; });
+}
+
 ndk::ScopedAStatus Lights::setLightState(int id, const HwLightState& state) {
-    switch(id) {
-        case (int) LightType::BACKLIGHT:
-            handleBacklight(state);
+    if (id >= 0 && id < (int) kMaxLightTypes) {
+        stats((LightType) id).recordCall();
+    }
+
+    if (id == (int) LightType::BACKLIGHT) {
+        handleBacklight(state);
+        return ndk::ScopedAStatus::ok();
+    }
+
+    for (auto& indicator : mIndicators) {
+        if (id == (int) indicator.type) {
+            handleIndicator(indicator, state);
             return ndk::ScopedAStatus::ok();
-        default:
-            return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+        }
     }
+
+    return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
 }
 
 ndk::ScopedAStatus Lights::getLights(std::vector<HwLight>* lights) {
     int i = 0;
 
     for (const LightType& backend : backends) {
+        if (!isAvailable(backend)) {
+            continue;
+        }
+
         HwLight hwLight;
         hwLight.id = (int) backend;
         hwLight.type = backend;
@@ -125,6 +270,26 @@ ndk::ScopedAStatus Lights::getLights(std::vector<HwLight>* lights) {
     return ndk::ScopedAStatus::ok();
 }
 
+binder_status_t Lights::dump(int fd, const char** args, uint32_t numArgs) {
+    if (numArgs == 1 && std::string(args[0]) == "reset") {
+        for (auto& stat : mStats) {
+            stat.reset();
+        }
+        ::android::base::WriteStringToFd("Light stats reset\n", fd);
+        return STATUS_OK;
+    }
+
+    for (const LightType& backend : backends) {
+        if (!isAvailable(backend)) {
+            continue;
+        }
+
+        ::android::base::WriteStringToFd(toString(backend) + ": " + stats(backend).dump(), fd);
+    }
+
+    return STATUS_OK;
+}
+
 }  // namespace light
 }  // namespace hardware
 }  // namespace android
@@ -10,8 +10,20 @@
 #include <android-base/logging.h>
 #include <hardware/hardware.h>
 #include <hardware/lights.h>
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
+#include "BacklightWriter.h"
+#include "BrightnessTable.h"
+#include "LedDevice.h"
+#include "LightStats.h"
+
+#define LEDS_ROOT "/sys/class/leds"
+
+using ::aidl::android::hardware::light::FlashMode;
 using ::aidl::android::hardware::light::HwLightState;
 using ::aidl::android::hardware::light::HwLight;
 using ::aidl::android::hardware::light::LightType;
@@ -23,8 +35,48 @@ namespace hardware {
 namespace light {
 
 class Lights : public BnLights {
+  public:
+      explicit Lights(const std::string& root = LEDS_ROOT);
+
       ndk::ScopedAStatus setLightState(int id, const HwLightState& state) override;
       ndk::ScopedAStatus getLights(std::vector<HwLight>* types) override;
+      binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+
+  private:
+      struct Indicator {
+          LightType type;
+          std::vector<LedDevice*> leds;
+          HwLightState state;
+      };
+
+      /* Large enough to index by any LightType. */
+      static constexpr size_t kMaxLightTypes = 16;
+
+      LedDevice* getLed(const std::string& root, const std::string& name);
+      bool isAvailable(LightType type) const;
+      LightStats& stats(LightType type) { return mStats[(size_t) type % kMaxLightTypes]; }
+
+      void handleBacklight(const HwLightState& state);
+      uint32_t getBacklightLevel(uint32_t color);
+      void setBacklightLevel(uint32_t level, uint32_t rampMs);
+      void handleIndicator(Indicator& indicator, const HwLightState& state);
+      void applyIndicator(const std::vector<LedDevice*>& leds, const HwLightState& state,
+                          LightStats& stats);
+
+      std::array<LightStats, kMaxLightTypes> mStats;
+
+      LedDevice mBacklight;
+      BrightnessTable mBacklightTable;
+      uint32_t mBacklightRampMs;
+      std::string mBacklightRampAttr;
+      uint32_t mBacklightKernelRampMs;
+      /* Last published on state, -1 until the first write. */
+      int mBacklightOn;
+      std::unique_ptr<BacklightWriter> mBacklightWriter;
+
+      std::map<std::string, std::unique_ptr<LedDevice>> mLeds;
+      /* Sorted in the order of importance. */
+      std::vector<Indicator> mIndicators;
 };
 
 }  // namespace light
@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "LightStats.h"
+
+#include <android-base/stringprintf.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+using ::android::base::StringAppendF;
+
+LightStats::LightStats() {
+    reset();
+}
+
+void LightStats::recordWrite(std::chrono::nanoseconds latency, bool ok) {
+    uint64_t ns = latency.count() > 0 ? latency.count() : 1;
+    size_t bucket = std::min<size_t>(63 - __builtin_clzll(ns), kBuckets - 1);
+    uint64_t max = mMaxLatencyNs.load(std::memory_order_relaxed);
+
+    mWrites.fetch_add(1, std::memory_order_relaxed);
+    if (!ok) {
+        mFailedWrites.fetch_add(1, std::memory_order_relaxed);
+    }
+    mLatency[bucket].fetch_add(1, std::memory_order_relaxed);
+
+    while (ns > max && !mMaxLatencyNs.compare_exchange_weak(max, ns, std::memory_order_relaxed)) {
+    }
+}
+
+void LightStats::reset() {
+    mCalls = 0;
+    mWrites = 0;
+    mFailedWrites = 0;
+    mCoalesced = 0;
+    mDropped = 0;
+    mMaxLatencyNs = 0;
+    for (auto& bucket : mLatency) {
+        bucket = 0;
+    }
+}
+
+std::string LightStats::dump() const {
+    std::string out;
+
+    StringAppendF(&out, "calls=%llu writes=%llu failed=%llu coalesced=%llu dropped=%llu max=%lluns\n",
+                  (unsigned long long) mCalls.load(), (unsigned long long) mWrites.load(),
+                  (unsigned long long) mFailedWrites.load(), (unsigned long long) mCoalesced.load(),
+                  (unsigned long long) mDropped.load(), (unsigned long long) mMaxLatencyNs.load());
+
+    for (size_t i = 0; i < kBuckets; i++) {
+        uint64_t count = mLatency[i].load();
+        if (count == 0) {
+            continue;
+        }
+
+        if (i == kBuckets - 1) {
+            StringAppendF(&out, "    >= %lluns: %llu\n", 1ull << i, (unsigned long long) count);
+        } else {
+            StringAppendF(&out, "    < %lluns: %llu\n", 1ull << (i + 1), (unsigned long long) count);
+        }
+    }
+
+    return out;
+}
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
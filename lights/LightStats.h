@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace light {
+
+/*
+ * Per light type counters, cheap enough to stay enabled in production.
+ *
+ * Everything is a relaxed atomic increment, write latencies go into
+ * power-of-two nanosecond buckets so no lock or allocation is needed on
+ * the write path.
+ */
+class LightStats {
+  public:
+    LightStats();
+
+    void recordCall() { mCalls.fetch_add(1, std::memory_order_relaxed); }
+    void recordCoalesced() { mCoalesced.fetch_add(1, std::memory_order_relaxed); }
+    void recordDropped() { mDropped.fetch_add(1, std::memory_order_relaxed); }
+    void recordWrite(std::chrono::nanoseconds latency, bool ok);
+
+    void reset();
+    std::string dump() const;
+
+  private:
+    /* Bucket i holds latencies in [2^i, 2^(i+1)) ns, the last one is open-ended. */
+    static constexpr size_t kBuckets = 32;
+
+    std::atomic<uint64_t> mCalls;
+    std::atomic<uint64_t> mWrites;
+    std::atomic<uint64_t> mFailedWrites;
+    std::atomic<uint64_t> mCoalesced;
+    std::atomic<uint64_t> mDropped;
+    std::atomic<uint64_t> mMaxLatencyNs;
+    std::array<std::atomic<uint64_t>, kBuckets> mLatency;
+};
+
+}  // namespace light
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -259,6 +259,14 @@ PRODUCT_PACKAGES += \
 PRODUCT_PACKAGES += \
     android.hardware.power-service.xiaomi-libperfmgr
 
+PRODUCT_PACKAGES += \
+    boot_boost \
+    swap_tune \
+    touch_boost
+
+PRODUCT_COPY_FILES += \
+    $(LOCAL_PATH)/configs/swap_tune.conf:$(TARGET_COPY_OUT_VENDOR)/etc/swap_tune.conf
+
 PRODUCT_PACKAGES += \
     libmtkperf_client_vendor \
     libmtkperf_client
@@ -342,6 +350,9 @@ PRODUCT_PACKAGES += \
 PRODUCT_PACKAGES += \
     fstab.mt6768 \
     fstab.mt6768_ramdisk \
+    fstab.zram.25 \
+    fstab.zram.50 \
+    fstab.zram.75 \
     init.ago.rc \
     init.connectivity.rc \
     init.modem.rc \
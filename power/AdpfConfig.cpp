@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "AdpfConfig.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <json/reader.h>
+#include <json/value.h>
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+bool AdpfConfig::load(const std::string& path) {
+    std::string content;
+    Json::Value root;
+    Json::Reader reader;
+
+    if (!::android::base::ReadFileToString(path, &content)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    if (!reader.parse(content, root)) {
+        LOG(ERROR) << "failed to parse " << path << ": " << reader.getFormattedErrorMessages();
+        return false;
+    }
+
+    const Json::Value& config = root["HintSessionConfig"];
+    if (!config.isObject()) {
+        LOG(INFO) << "no HintSessionConfig in " << path << ", using defaults";
+        return true;
+    }
+
+    enabled = config.get("Enabled", enabled).asBool();
+    reportingRateNs = config.get("ReportingRateLimitNs", Json::Int64(reportingRateNs)).asInt64();
+    pidP = config.get("PidP", pidP).asFloat();
+    pidI = config.get("PidI", pidI).asFloat();
+    pidD = config.get("PidD", pidD).asFloat();
+    pidIMin = config.get("PidIMin", pidIMin).asFloat();
+    pidIMax = config.get("PidIMax", pidIMax).asFloat();
+    uclampMinLow = std::clamp(config.get("UclampMinLow", uclampMinLow).asInt(), 0, 1024);
+    uclampMinHigh = std::clamp(config.get("UclampMinHigh", uclampMinHigh).asInt(), uclampMinLow,
+                               1024);
+    staleTime = std::chrono::milliseconds(
+            config.get("StaleTimeMs", Json::Int64(staleTime.count())).asInt64());
+
+    if (pidIMin > pidIMax || reportingRateNs <= 0 || staleTime.count() <= 0) {
+        LOG(ERROR) << "invalid HintSessionConfig in " << path;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,51 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * Hint session tuning, read from the "HintSessionConfig" object in
+ * powerhint.json. libperfmgr ignores keys it doesn't know, so it can live
+ * next to the nodes it complements.
+ */
+struct AdpfConfig {
+    bool enabled = true;
+    /* How often the framework should report work durations. */
+    int64_t reportingRateNs = 16666667;
+
+    /*
+     * PID gains from the overrun, as a fraction of the target duration, to
+     * uclamp.min in 0..1024. The integral term is kept within its bounds so
+     * a long stall can't wind it up.
+     */
+    float pidP = 512;
+    float pidI = 128;
+    float pidD = 64;
+    float pidIMin = -128;
+    float pidIMax = 512;
+
+    int uclampMinLow = 0;
+    int uclampMinHigh = 512;
+
+    /* Boost is dropped when a session stops reporting for this long. */
+    std::chrono::milliseconds staleTime{100};
+
+    bool load(const std::string& path);
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,44 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PidController.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+PidController::PidController(const AdpfConfig& config) : mConfig(config) {
+    reset();
+}
+
+int PidController::update(float error) {
+    float derivative = mHaveLastError ? error - mLastError : 0;
+
+    mIntegral = std::clamp(mIntegral + mConfig.pidI * error, mConfig.pidIMin, mConfig.pidIMax);
+    mLastError = error;
+    mHaveLastError = true;
+
+    float output = mConfig.pidP * error + mIntegral + mConfig.pidD * derivative;
+    mOutput = std::clamp(int(std::lround(output)), mConfig.uclampMinLow, mConfig.uclampMinHigh);
+
+    return mOutput;
+}
+
+void PidController::reset() {
+    mIntegral = 0;
+    mLastError = 0;
+    mHaveLastError = false;
+    mOutput = mConfig.uclampMinLow;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,41 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "AdpfConfig.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/* Turns frame overruns into a uclamp.min, one sample per reported frame. */
+class PidController {
+  public:
+    explicit PidController(const AdpfConfig& config);
+
+    /*
+     * error is how far the work overran its target, as a fraction of the
+     * target, negative when it finished early. Returns the new output.
+     */
+    int update(float error);
+    void reset();
+
+    int output() const { return mOutput; }
+
+  private:
+    const AdpfConfig& mConfig;
+    float mIntegral;
+    float mLastError;
+    bool mHaveLastError;
+    int mOutput;
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PidController.h"
+
+#include <gtest/gtest.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+TEST(PidControllerTest, StartsAtLowBound) {
+    AdpfConfig config;
+    config.uclampMinLow = 10;
+
+    PidController pid(config);
+
+    EXPECT_EQ(pid.output(), 10);
+}
+
+TEST(PidControllerTest, OnTargetHoldsLowBound) {
+    AdpfConfig config;
+    PidController pid(config);
+
+    for (int i = 0; i < 100; i++) {
+        EXPECT_EQ(pid.update(0), 0);
+    }
+}
+
+TEST(PidControllerTest, OverrunRaisesOutput) {
+    AdpfConfig config;
+    PidController pid(config);
+
+    /* P 512 * 0.1 + I 128 * 0.1, no derivative on the first sample */
+    EXPECT_EQ(pid.update(0.1f), 64);
+    /* The integral keeps growing while the overrun persists */
+    EXPECT_EQ(pid.update(0.1f), 77);
+    EXPECT_EQ(pid.update(0.1f), 90);
+}
+
+TEST(PidControllerTest, EarlyFinishDropsToLowBound) {
+    AdpfConfig config;
+    PidController pid(config);
+
+    pid.update(0.2f);
+    EXPECT_GT(pid.output(), 0);
+
+    EXPECT_EQ(pid.update(-0.5f), 0);
+}
+
+TEST(PidControllerTest, OutputIsClamped) {
+    AdpfConfig config;
+    config.uclampMinLow = 50;
+    config.uclampMinHigh = 300;
+
+    PidController pid(config);
+
+    EXPECT_EQ(pid.update(10), 300);
+    EXPECT_EQ(pid.update(-10), 50);
+}
+
+TEST(PidControllerTest, DerivativeNeedsTwoSamples) {
+    AdpfConfig config;
+    config.pidP = 0;
+    config.pidI = 0;
+    config.pidD = 64;
+
+    PidController pid(config);
+
+    EXPECT_EQ(pid.update(1), 0);
+    EXPECT_EQ(pid.update(2), 64);
+    EXPECT_EQ(pid.update(2), 0);
+}
+
+TEST(PidControllerTest, IntegralDoesNotWindUp) {
+    AdpfConfig config;
+    PidController pid(config);
+
+    /* A long stall pins the integral at its upper bound, no further */
+    for (int i = 0; i < 1000; i++) {
+        pid.update(1);
+    }
+    EXPECT_EQ(pid.output(), config.uclampMinHigh);
+
+    /* So it unwinds in a handful of early frames instead of a thousand */
+    int frames = 0;
+    while (pid.update(-0.5f) > 0) {
+        frames++;
+        ASSERT_LT(frames, 8);
+    }
+}
+
+TEST(PidControllerTest, ResetForgetsHistory) {
+    AdpfConfig config;
+    PidController pid(config);
+
+    for (int i = 0; i < 10; i++) {
+        pid.update(1);
+    }
+    pid.reset();
+
+    EXPECT_EQ(pid.output(), 0);
+    /* Same as a fresh controller: no integral and no derivative */
+    EXPECT_EQ(pid.update(0.1f), 64);
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "android.hardware.power-service.mt6768"
+
+#include "Power.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <perfmgr/HintManager.h>
+
+#include <algorithm>
+#include <thread>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+using ::android::perfmgr::HintManager;
+
+/* Set by init once boot completes, see init.mt6768.rc. */
+constexpr char kPowerHalInitProp[] = "vendor.powerhal.init";
+
+Power::Power(std::shared_ptr<const AdpfConfig> adpfConfig,
+             std::shared_ptr<ThermalGovernor> thermalGovernor)
+    : mAdpfConfig(std::move(adpfConfig)),
+      mThermalGovernor(std::move(thermalGovernor)),
+      mReady(false) {
+    /* GetInstance() only parses powerhint.json, nodes are written once the looper starts. */
+    std::thread initThread([this]() {
+        ::android::base::WaitForProperty(kPowerHalInitProp, "1");
+        HintManager::GetInstance()->Start();
+        mReady = true;
+        LOG(INFO) << "libperfmgr started";
+    });
+    initThread.detach();
+}
+
+ndk::ScopedAStatus Power::setMode(Mode type, bool enabled) {
+    LOG(VERBOSE) << "setMode " << toString(type) << " " << enabled;
+
+    if (type == Mode::DOUBLE_TAP_TO_WAKE) {
+        if (!::android::base::WriteStringToFile(enabled ? "1" : "0", TAP_TO_WAKE_NODE, true)) {
+            PLOG(ERROR) << "failed to write " << TAP_TO_WAKE_NODE;
+        }
+        return ndk::ScopedAStatus::ok();
+    }
+
+    if (!mReady || !HintManager::GetInstance()->IsHintSupported(toString(type))) {
+        return ndk::ScopedAStatus::ok();
+    }
+
+    if (enabled) {
+        HintManager::GetInstance()->DoHint(toString(type));
+    } else {
+        HintManager::GetInstance()->EndHint(toString(type));
+    }
+
+    /* The mode itself only sets state, its caps come from the governor's levels. */
+    if (type == Mode::SUSTAINED_PERFORMANCE) {
+        if (enabled) {
+            mThermalGovernor->start();
+        } else {
+            mThermalGovernor->stop();
+        }
+    }
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Power::isModeSupported(Mode type, bool* _aidl_return) {
+    if (type == Mode::DOUBLE_TAP_TO_WAKE) {
+        *_aidl_return = true;
+        return ndk::ScopedAStatus::ok();
+    }
+
+    *_aidl_return = HintManager::GetInstance()->IsHintSupported(toString(type));
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Power::setBoost(Boost type, int32_t durationMs) {
+    LOG(VERBOSE) << "setBoost " << toString(type) << " " << durationMs;
+
+    if (!mReady || !HintManager::GetInstance()->IsHintSupported(toString(type))) {
+        return ndk::ScopedAStatus::ok();
+    }
+
+    /* A negative duration cancels, 0 keeps the durations from powerhint.json. */
+    if (durationMs > 0) {
+        HintManager::GetInstance()->DoHint(toString(type), std::chrono::milliseconds(durationMs));
+    } else if (durationMs == 0) {
+        HintManager::GetInstance()->DoHint(toString(type));
+    } else {
+        HintManager::GetInstance()->EndHint(toString(type));
+    }
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Power::isBoostSupported(Boost type, bool* _aidl_return) {
+    *_aidl_return = HintManager::GetInstance()->IsHintSupported(toString(type));
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Power::createHintSession(int32_t tgid, int32_t uid,
+                                            const std::vector<int32_t>& threadIds,
+                                            int64_t durationNanos,
+                                            std::shared_ptr<IPowerHintSession>* _aidl_return) {
+    *_aidl_return = nullptr;
+
+    if (!mAdpfConfig->enabled) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+    }
+    if (threadIds.empty() || durationNanos <= 0) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+    }
+
+    auto session = ndk::SharedRefBase::make<PowerHintSession>(mAdpfConfig, tgid, uid, threadIds,
+                                                              durationNanos);
+
+    std::lock_guard<std::mutex> lock(mSessionsLock);
+    mSessions.erase(std::remove_if(mSessions.begin(), mSessions.end(),
+                                   [](const auto& session) { return session.expired(); }),
+                    mSessions.end());
+    mSessions.push_back(session);
+
+    *_aidl_return = session;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus Power::getHintSessionPreferredRate(int64_t* outNanoseconds) {
+    if (!mAdpfConfig->enabled) {
+        *outNanoseconds = -1;
+        return ndk::ScopedAStatus::fromExceptionCode(EX_UNSUPPORTED_OPERATION);
+    }
+
+    *outNanoseconds = mAdpfConfig->reportingRateNs;
+    return ndk::ScopedAStatus::ok();
+}
+
+binder_status_t Power::dump(int fd, const char** /* args */, uint32_t /* numArgs */) {
+    std::string sessions;
+
+    HintManager::GetInstance()->DumpToFd(fd);
+
+    {
+        std::lock_guard<std::mutex> lock(mSessionsLock);
+        for (const auto& weak : mSessions) {
+            if (auto session = weak.lock()) {
+                sessions += session->dump();
+            }
+        }
+    }
+
+    ::android::base::WriteStringToFd("Hint sessions:\n" + (sessions.empty() ? "none\n" : sessions),
+                                     fd);
+    ::android::base::WriteStringToFd(mThermalGovernor->dump(), fd);
+    return STATUS_OK;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/power/BnPower.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "AdpfConfig.h"
+#include "PowerHintSession.h"
+#include "ThermalGovernor.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * Modes and boosts run the powerhint.json action of the same name through
+ * libperfmgr, hint sessions are handled here. SUSTAINED_PERFORMANCE also
+ * runs the thermal governor for as long as it is on, DOUBLE_TAP_TO_WAKE writes
+ * the touchpanel node directly.
+ */
+class Power : public BnPower {
+  public:
+    Power(std::shared_ptr<const AdpfConfig> adpfConfig,
+          std::shared_ptr<ThermalGovernor> thermalGovernor);
+
+    ndk::ScopedAStatus setMode(Mode type, bool enabled) override;
+    ndk::ScopedAStatus isModeSupported(Mode type, bool* _aidl_return) override;
+    ndk::ScopedAStatus setBoost(Boost type, int32_t durationMs) override;
+    ndk::ScopedAStatus isBoostSupported(Boost type, bool* _aidl_return) override;
+    ndk::ScopedAStatus createHintSession(int32_t tgid, int32_t uid,
+                                         const std::vector<int32_t>& threadIds,
+                                         int64_t durationNanos,
+                                         std::shared_ptr<IPowerHintSession>* _aidl_return) override;
+    ndk::ScopedAStatus getHintSessionPreferredRate(int64_t* outNanoseconds) override;
+    binder_status_t dump(int fd, const char** args, uint32_t numArgs) override;
+
+    const std::atomic<bool>& ready() const { return mReady; }
+
+  private:
+    const std::shared_ptr<const AdpfConfig> mAdpfConfig;
+    const std::shared_ptr<ThermalGovernor> mThermalGovernor;
+    /* Set once libperfmgr's looper runs, hints before that would never reach sysfs. */
+    std::atomic<bool> mReady;
+
+    std::mutex mSessionsLock;
+    /* Only for dump, sessions belong to their clients. */
+    std::vector<std::weak_ptr<PowerHintSession>> mSessions;
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "android.hardware.power-service.mt6768"
+
+#include "PowerExt.h"
+
+#include <android-base/logging.h>
+#include <perfmgr/HintManager.h>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace extension {
+namespace pixel {
+
+using ::android::perfmgr::HintManager;
+
+ndk::ScopedAStatus PowerExt::setMode(const std::string& mode, bool enabled) {
+    LOG(VERBOSE) << "setMode " << mode << " " << enabled;
+
+    if (!mReady || !HintManager::GetInstance()->IsHintSupported(mode)) {
+        return ndk::ScopedAStatus::ok();
+    }
+
+    if (enabled) {
+        HintManager::GetInstance()->DoHint(mode);
+    } else {
+        HintManager::GetInstance()->EndHint(mode);
+    }
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerExt::isModeSupported(const std::string& mode, bool* _aidl_return) {
+    *_aidl_return = HintManager::GetInstance()->IsHintSupported(mode);
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerExt::setBoost(const std::string& boost, int32_t durationMs) {
+    LOG(VERBOSE) << "setBoost " << boost << " " << durationMs;
+
+    if (!mReady || !HintManager::GetInstance()->IsHintSupported(boost)) {
+        return ndk::ScopedAStatus::ok();
+    }
+
+    /* Same as IPower: a negative duration cancels, 0 keeps the JSON's. */
+    if (durationMs > 0) {
+        HintManager::GetInstance()->DoHint(boost, std::chrono::milliseconds(durationMs));
+    } else if (durationMs == 0) {
+        HintManager::GetInstance()->DoHint(boost);
+    } else {
+        HintManager::GetInstance()->EndHint(boost);
+    }
+
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerExt::isBoostSupported(const std::string& boost, bool* _aidl_return) {
+    *_aidl_return = HintManager::GetInstance()->IsHintSupported(boost);
+    return ndk::ScopedAStatus::ok();
+}
+
+}  // namespace pixel
+}  // namespace extension
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
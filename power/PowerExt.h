@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/google/hardware/power/extension/pixel/BnPowerExt.h>
+
+#include <atomic>
+
+namespace aidl {
+namespace google {
+namespace hardware {
+namespace power {
+namespace extension {
+namespace pixel {
+
+/*
+ * Runs any powerhint.json hint by name, for clients whose requests have no
+ * IPower equivalent, such as the per-node floors of libmtkperf_client.
+ */
+class PowerExt : public BnPowerExt {
+  public:
+    explicit PowerExt(const std::atomic<bool>& ready) : mReady(ready) {}
+
+    ndk::ScopedAStatus setMode(const std::string& mode, bool enabled) override;
+    ndk::ScopedAStatus isModeSupported(const std::string& mode, bool* _aidl_return) override;
+    ndk::ScopedAStatus setBoost(const std::string& boost, int32_t durationMs) override;
+    ndk::ScopedAStatus isBoostSupported(const std::string& boost, bool* _aidl_return) override;
+
+  private:
+    /* Power's, hints before libperfmgr starts would never reach sysfs. */
+    const std::atomic<bool>& mReady;
+};
+
+}  // namespace pixel
+}  // namespace extension
+}  // namespace power
+}  // namespace hardware
+}  // namespace google
+}  // namespace aidl
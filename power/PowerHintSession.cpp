@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PowerHintSession.h"
+
+#include <android-base/logging.h>
+#include <android-base/stringprintf.h>
+#include <mtkperf_client.h>
+
+#define UCLAMP_MAX 1024
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+using ::android::base::StringPrintf;
+
+PowerHintSession::PowerHintSession(std::shared_ptr<const AdpfConfig> config, int32_t tgid,
+                                   int32_t uid, const std::vector<int32_t>& threadIds,
+                                   int64_t targetDurationNanos)
+    : mConfig(std::move(config)),
+      mTgid(tgid),
+      mUid(uid),
+      mThreadIds(threadIds),
+      mTargetNs(targetDurationNanos),
+      mPid(*mConfig),
+      mHandles(threadIds.size(), -1),
+      mPaused(false),
+      mClosed(false),
+      mFrames(0),
+      mOverruns(0),
+      mLastActualNs(0) {}
+
+PowerHintSession::~PowerHintSession() {
+    close();
+}
+
+void PowerHintSession::setBoost(int uclampMin) {
+    if (uclampMin <= 0) {
+        releaseBoost();
+        return;
+    }
+
+    for (size_t i = 0; i < mThreadIds.size(); i++) {
+        mHandles[i] = perf_thread_lock_acq(mHandles[i], mConfig->staleTime.count(), mThreadIds[i],
+                                           uclampMin, UCLAMP_MAX);
+        if (mHandles[i] < 0) {
+            LOG(WARNING) << "failed to boost thread " << mThreadIds[i] << " of " << mTgid;
+        }
+    }
+}
+
+void PowerHintSession::releaseBoost() {
+    for (int& handle : mHandles) {
+        /* Fails harmlessly on a lock that already timed out. */
+        if (handle > 0) {
+            perf_lock_rel(handle);
+        }
+        handle = -1;
+    }
+}
+
+ndk::ScopedAStatus PowerHintSession::updateTargetWorkDuration(int64_t targetDurationNanos) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (targetDurationNanos <= 0) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+    }
+    if (mClosed) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+
+    mTargetNs = targetDurationNanos;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerHintSession::reportActualWorkDuration(
+        const std::vector<WorkDuration>& actualDurations) {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (actualDurations.empty()) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_ARGUMENT);
+    }
+    if (mClosed || mPaused) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+
+    /* Frames are batched by the framework, run the controller over each. */
+    for (const WorkDuration& duration : actualDurations) {
+        if (duration.durationNanos <= 0) {
+            continue;
+        }
+
+        mPid.update(float(duration.durationNanos - mTargetNs) / mTargetNs);
+        mFrames++;
+        if (duration.durationNanos > mTargetNs) {
+            mOverruns++;
+        }
+        mLastActualNs = duration.durationNanos;
+    }
+
+    setBoost(mPid.output());
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerHintSession::pause() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mClosed) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+
+    mPaused = true;
+    releaseBoost();
+    mPid.reset();
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerHintSession::resume() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mClosed) {
+        return ndk::ScopedAStatus::fromExceptionCode(EX_ILLEGAL_STATE);
+    }
+
+    mPaused = false;
+    return ndk::ScopedAStatus::ok();
+}
+
+ndk::ScopedAStatus PowerHintSession::close() {
+    std::lock_guard<std::mutex> lock(mLock);
+
+    mClosed = true;
+    releaseBoost();
+    return ndk::ScopedAStatus::ok();
+}
+
+std::string PowerHintSession::dump() {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::string threads;
+
+    for (int32_t tid : mThreadIds) {
+        threads += (threads.empty() ? "" : ",") + std::to_string(tid);
+    }
+
+    return StringPrintf("tgid %d uid %d threads [%s] target %.2fms last %.2fms uclamp.min %d "
+                        "frames %llu overruns %llu%s\n",
+                        mTgid, mUid, threads.c_str(), mTargetNs / 1e6, mLastActualNs / 1e6,
+                        mPid.output(), (unsigned long long)mFrames, (unsigned long long)mOverruns,
+                        mClosed ? " closed" : mPaused ? " paused" : "");
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <aidl/android/hardware/power/BnPowerHintSession.h>
+#include <aidl/android/hardware/power/WorkDuration.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "AdpfConfig.h"
+#include "PidController.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * An ADPF session. Every reported frame feeds the PID controller, whose
+ * output becomes uclamp.min on each of the session's threads through a
+ * per-thread perf lock. The locks time out after the stale time, so a
+ * session that stops reporting loses its boost without a timer here.
+ */
+class PowerHintSession : public BnPowerHintSession {
+  public:
+    PowerHintSession(std::shared_ptr<const AdpfConfig> config, int32_t tgid, int32_t uid,
+                     const std::vector<int32_t>& threadIds, int64_t targetDurationNanos);
+    ~PowerHintSession();
+
+    ndk::ScopedAStatus updateTargetWorkDuration(int64_t targetDurationNanos) override;
+    ndk::ScopedAStatus reportActualWorkDuration(
+            const std::vector<WorkDuration>& actualDurations) override;
+    ndk::ScopedAStatus pause() override;
+    ndk::ScopedAStatus resume() override;
+    ndk::ScopedAStatus close() override;
+
+    std::string dump();
+
+  private:
+    void setBoost(int uclampMin);
+    void releaseBoost();
+
+    const std::shared_ptr<const AdpfConfig> mConfig;
+    const int32_t mTgid;
+    const int32_t mUid;
+    const std::vector<int32_t> mThreadIds;
+
+    std::mutex mLock;
+    int64_t mTargetNs;
+    PidController mPid;
+    /* Perf lock per thread, in the order of mThreadIds, -1 if not held. */
+    std::vector<int> mHandles;
+    bool mPaused;
+    bool mClosed;
+
+    uint64_t mFrames;
+    uint64_t mOverruns;
+    int64_t mLastActualNs;
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,224 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "PowerHintSession.h"
+
+#include <gtest/gtest.h>
+#include <mtkperf_client.h>
+
+#include <map>
+
+/*
+ * Stand-in for libmtkperf_client: keeps the per-thread locks a session
+ * holds so the tests can look at them.
+ */
+namespace {
+
+struct ThreadLock {
+    int dur;
+    int tid;
+    int uclampMin;
+};
+
+std::map<int, ThreadLock> sLocks;
+int sNextHandle;
+bool sFailAcquire;
+int sAcquires;
+int sReleases;
+
+}  // anonymous namespace
+
+extern "C" int perf_thread_lock_acq(int hdl, int dur, int tid, int uclamp_min, int) {
+    if (sFailAcquire) {
+        return -1;
+    }
+    sAcquires++;
+    if (sLocks.find(hdl) == sLocks.end()) {
+        hdl = ++sNextHandle;
+    }
+    sLocks[hdl] = {dur, tid, uclamp_min};
+    return hdl;
+}
+
+extern "C" int perf_lock_rel(int hdl) {
+    sReleases++;
+    return sLocks.erase(hdl) ? 0 : -1;
+}
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+namespace {
+
+constexpr int64_t kTargetNs = 16666667;
+
+WorkDuration frame(int64_t durationNanos) {
+    WorkDuration duration;
+
+    duration.durationNanos = durationNanos;
+    return duration;
+}
+
+}  // anonymous namespace
+
+class PowerHintSessionTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        sLocks.clear();
+        sNextHandle = 0;
+        sFailAcquire = false;
+        sAcquires = 0;
+        sReleases = 0;
+
+        mConfig = std::make_shared<AdpfConfig>();
+        mSession = ndk::SharedRefBase::make<PowerHintSession>(mConfig, 1000, 10001,
+                                                              std::vector<int32_t>{1000, 1001},
+                                                              kTargetNs);
+    }
+
+    /* The boost on tid, 0 if it holds no lock. */
+    int boostOf(int tid) {
+        for (auto const& [handle, lock] : sLocks) {
+            if (lock.tid == tid) {
+                return lock.uclampMin;
+            }
+        }
+        return 0;
+    }
+
+    std::shared_ptr<AdpfConfig> mConfig;
+    std::shared_ptr<PowerHintSession> mSession;
+};
+
+TEST_F(PowerHintSessionTest, OverrunBoostsEveryThread) {
+    ASSERT_TRUE(mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10)}).isOk());
+
+    ASSERT_EQ(sLocks.size(), 2u);
+    EXPECT_EQ(boostOf(1000), 64);
+    EXPECT_EQ(boostOf(1001), 64);
+    for (auto const& [handle, lock] : sLocks) {
+        EXPECT_EQ(lock.dur, mConfig->staleTime.count());
+    }
+}
+
+TEST_F(PowerHintSessionTest, ReportsRenewTheSameLocks) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10)});
+    auto first = sLocks;
+
+    mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10)});
+
+    ASSERT_EQ(sLocks.size(), 2u);
+    for (auto const& [handle, lock] : first) {
+        ASSERT_EQ(sLocks.count(handle), 1u);
+        EXPECT_GT(sLocks[handle].uclampMin, lock.uclampMin);
+    }
+}
+
+TEST_F(PowerHintSessionTest, BatchedFramesAllFeedTheController) {
+    mSession->reportActualWorkDuration(
+            {frame(kTargetNs * 11 / 10), frame(kTargetNs * 11 / 10), frame(kTargetNs * 11 / 10)});
+
+    /* Same as three reports of one frame each */
+    EXPECT_EQ(boostOf(1000), 90);
+}
+
+TEST_F(PowerHintSessionTest, OnTargetHoldsNoLocks) {
+    ASSERT_TRUE(mSession->reportActualWorkDuration({frame(kTargetNs / 2)}).isOk());
+
+    EXPECT_TRUE(sLocks.empty());
+    EXPECT_EQ(sAcquires, 0);
+}
+
+TEST_F(PowerHintSessionTest, EarlyFramesReleaseTheBoost) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+    ASSERT_EQ(sLocks.size(), 2u);
+
+    mSession->reportActualWorkDuration({frame(kTargetNs / 2)});
+
+    EXPECT_TRUE(sLocks.empty());
+}
+
+TEST_F(PowerHintSessionTest, PauseReleasesAndRejectsReports) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+
+    ASSERT_TRUE(mSession->pause().isOk());
+    EXPECT_TRUE(sLocks.empty());
+
+    auto status = mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+    EXPECT_EQ(status.getExceptionCode(), EX_ILLEGAL_STATE);
+    EXPECT_TRUE(sLocks.empty());
+
+    /* The controller starts over after a resume */
+    ASSERT_TRUE(mSession->resume().isOk());
+    mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10)});
+    EXPECT_EQ(boostOf(1000), 64);
+}
+
+TEST_F(PowerHintSessionTest, CloseReleasesAndRejectsEverything) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+
+    ASSERT_TRUE(mSession->close().isOk());
+    EXPECT_TRUE(sLocks.empty());
+
+    EXPECT_EQ(mSession->reportActualWorkDuration({frame(kTargetNs)}).getExceptionCode(),
+              EX_ILLEGAL_STATE);
+    EXPECT_EQ(mSession->updateTargetWorkDuration(kTargetNs).getExceptionCode(), EX_ILLEGAL_STATE);
+    EXPECT_EQ(mSession->pause().getExceptionCode(), EX_ILLEGAL_STATE);
+    EXPECT_EQ(mSession->resume().getExceptionCode(), EX_ILLEGAL_STATE);
+}
+
+TEST_F(PowerHintSessionTest, DestructionReleases) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+    ASSERT_EQ(sLocks.size(), 2u);
+
+    mSession.reset();
+
+    EXPECT_TRUE(sLocks.empty());
+}
+
+TEST_F(PowerHintSessionTest, RejectsBadArguments) {
+    EXPECT_EQ(mSession->reportActualWorkDuration({}).getExceptionCode(), EX_ILLEGAL_ARGUMENT);
+    EXPECT_EQ(mSession->updateTargetWorkDuration(0).getExceptionCode(), EX_ILLEGAL_ARGUMENT);
+    EXPECT_EQ(mSession->updateTargetWorkDuration(-1).getExceptionCode(), EX_ILLEGAL_ARGUMENT);
+
+    /* Empty frames are skipped, not fed to the controller */
+    ASSERT_TRUE(mSession->reportActualWorkDuration({frame(0)}).isOk());
+    EXPECT_TRUE(sLocks.empty());
+}
+
+TEST_F(PowerHintSessionTest, NewTargetChangesTheError) {
+    ASSERT_TRUE(mSession->updateTargetWorkDuration(kTargetNs * 2).isOk());
+
+    /* An overrun against the old target is early against the new one */
+    mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10)});
+    EXPECT_TRUE(sLocks.empty());
+}
+
+TEST_F(PowerHintSessionTest, FailedAcquireIsNotReleased) {
+    sFailAcquire = true;
+    mSession->reportActualWorkDuration({frame(kTargetNs * 12 / 10)});
+    EXPECT_TRUE(sLocks.empty());
+
+    mSession->close();
+    EXPECT_EQ(sReleases, 0);
+}
+
+TEST_F(PowerHintSessionTest, DumpShowsState) {
+    mSession->reportActualWorkDuration({frame(kTargetNs * 11 / 10), frame(kTargetNs / 2)});
+    mSession->pause();
+
+    std::string dump = mSession->dump();
+
+    EXPECT_NE(dump.find("tgid 1000 uid 10001 threads [1000,1001]"), std::string::npos) << dump;
+    EXPECT_NE(dump.find("frames 2 overruns 1 paused"), std::string::npos) << dump;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ThermalConfig.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <json/reader.h>
+#include <json/value.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+static std::vector<std::string> stringList(const Json::Value& value,
+                                           const std::vector<std::string>& fallback) {
+    std::vector<std::string> list;
+
+    if (!value.isArray()) {
+        return fallback;
+    }
+
+    for (const auto& entry : value) {
+        list.push_back(entry.asString());
+    }
+
+    return list;
+}
+
+bool ThermalConfig::load(const std::string& path) {
+    std::string content;
+    Json::Value root;
+    Json::Reader reader;
+
+    if (!::android::base::ReadFileToString(path, &content)) {
+        PLOG(ERROR) << "failed to read " << path;
+        return false;
+    }
+
+    if (!reader.parse(content, root)) {
+        LOG(ERROR) << "failed to parse " << path << ": " << reader.getFormattedErrorMessages();
+        return false;
+    }
+
+    const Json::Value& config = root["ThermalGovernorConfig"];
+    if (!config.isObject()) {
+        LOG(INFO) << "no ThermalGovernorConfig in " << path << ", thermal governor disabled";
+        enabled = false;
+        return true;
+    }
+
+    enabled = config.get("Enabled", enabled).asBool();
+    sensors = stringList(config["Sensors"], sensors);
+    targetC = config.get("TargetC", targetC).asFloat();
+    samplingInterval = std::chrono::milliseconds(
+            config.get("SamplingIntervalMs", Json::Int64(samplingInterval.count())).asInt64());
+    smoothing = std::chrono::milliseconds(
+            config.get("SmoothingMs", Json::Int64(smoothing.count())).asInt64());
+    kp = config.get("Kp", kp).asFloat();
+    ki = config.get("Ki", ki).asFloat();
+    hysteresis = config.get("Hysteresis", hysteresis).asFloat();
+    levels = stringList(config["Levels"], levels);
+
+    if (sensors.empty() || levels.empty() || samplingInterval.count() <= 0 ||
+        smoothing.count() < 0 || kp < 0 || ki < 0 || hysteresis < 0 || hysteresis >= 0.5) {
+        LOG(ERROR) << "invalid ThermalGovernorConfig in " << path;
+        return false;
+    }
+
+    return true;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
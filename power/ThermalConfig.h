@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * SUSTAINED_PERFORMANCE thermal governor tuning, read from the
+ * "ThermalGovernorConfig" object in powerhint.json.
+ */
+struct ThermalConfig {
+    bool enabled = true;
+
+    /* Thermal zone types standing in for skin temperature, the hottest one counts. */
+    std::vector<std::string> sensors{"mtktsAP"};
+    float targetC = 40;
+
+    std::chrono::milliseconds samplingInterval{2000};
+    /* Time constant of the low-pass filter on the readings. */
+    std::chrono::milliseconds smoothing{10000};
+
+    /*
+     * PI gains from degrees above target to levels, per degree and per
+     * degree-second. The integral is kept within the levels.
+     */
+    float kp = 1.0;
+    float ki = 0.01;
+    /* How far past the midpoint between two levels the output has to go to switch. */
+    float hysteresis = 0.35;
+
+    /*
+     * powerhint.json hints holding the caps, from the coolest to the
+     * most throttled. The first one is held while the governor is off.
+     */
+    std::vector<std::string> levels;
+
+    bool load(const std::string& path);
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,59 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ThermalController.h"
+
+#include <algorithm>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+ThermalController::ThermalController(const ThermalConfig& config)
+    : mConfig(config), mMaxLevel(std::max(int(config.levels.size()) - 1, 0)) {
+    reset();
+}
+
+int ThermalController::update(float tempC, std::chrono::milliseconds dt) {
+    float seconds = std::chrono::duration<float>(dt).count();
+
+    if (!mHaveReading) {
+        mFiltered = tempC;
+        mHaveReading = true;
+    } else {
+        float smoothing = std::chrono::duration<float>(mConfig.smoothing).count();
+        mFiltered += (tempC - mFiltered) * seconds / (smoothing + seconds);
+    }
+
+    float error = mFiltered - mConfig.targetC;
+
+    /* Bounded by the levels, so a cool start or a boost holding the caps can't wind it up. */
+    mIntegral = std::clamp(mIntegral + mConfig.ki * error * seconds, 0.0f, float(mMaxLevel));
+    mOutput = std::clamp(mConfig.kp * error + mIntegral, 0.0f, float(mMaxLevel));
+
+    float threshold = 0.5f + mConfig.hysteresis;
+    if (mOutput >= mLevel + threshold) {
+        mLevel++;
+    } else if (mOutput <= mLevel - threshold) {
+        mLevel--;
+    }
+
+    return mLevel;
+}
+
+void ThermalController::reset() {
+    mHaveReading = false;
+    mFiltered = 0;
+    mIntegral = 0;
+    mOutput = 0;
+    mLevel = 0;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+
+#include "ThermalConfig.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * Turns skin temperature into a cap level, 0 being the coolest. Skin heats
+ * up over minutes, so the level moves at most one step per sample and
+ * only once the PI output is clearly past the next level.
+ */
+class ThermalController {
+  public:
+    explicit ThermalController(const ThermalConfig& config);
+
+    /* Feeds a reading taken dt after the previous one, returns the level to hold. */
+    int update(float tempC, std::chrono::milliseconds dt);
+    void reset();
+
+    int level() const { return mLevel; }
+    float filtered() const { return mFiltered; }
+    float output() const { return mOutput; }
+
+  private:
+    const ThermalConfig& mConfig;
+    const int mMaxLevel;
+    bool mHaveReading;
+    float mFiltered;
+    float mIntegral;
+    float mOutput;
+    int mLevel;
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
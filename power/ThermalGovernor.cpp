@@ -0,0 +1,239 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "ThermalGovernor.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <perfmgr/HintManager.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <dirent.h>
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+using ::android::base::StringAppendF;
+using ::android::base::StringPrintf;
+using ::android::perfmgr::HintManager;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+/* Zones without a sensor behind them report -127C on MediaTek. */
+constexpr int kMinValidMilliC = -40000;
+constexpr int kMaxValidMilliC = 150000;
+
+ThermalGovernor::ThermalGovernor(std::shared_ptr<const ThermalConfig> config,
+                                 std::string thermalRoot)
+    : mConfig(std::move(config)),
+      mThermalRoot(std::move(thermalRoot)),
+      mRunning(false),
+      mController(*mConfig),
+      mAppliedLevel(-1),
+      mLastTempC(0),
+      mSamples(0),
+      mReadFailures(0),
+      mLevelChanges(0),
+      mTimeAtLevel(mConfig->levels.size()) {}
+
+ThermalGovernor::~ThermalGovernor() {
+    stop();
+}
+
+void ThermalGovernor::findSensors() {
+    std::unique_ptr<DIR, int (*)(DIR*)> dir(opendir(mThermalRoot.c_str()), closedir);
+
+    mSensorPaths.clear();
+    if (!dir) {
+        PLOG(ERROR) << "failed to list " << mThermalRoot;
+        return;
+    }
+
+    while (dirent* entry = readdir(dir.get())) {
+        std::string zone = mThermalRoot + "/" + entry->d_name;
+        std::string type;
+
+        if (!::android::base::StartsWith(entry->d_name, "thermal_zone") ||
+            !::android::base::ReadFileToString(zone + "/type", &type)) {
+            continue;
+        }
+
+        type = ::android::base::Trim(type);
+        if (std::find(mConfig->sensors.begin(), mConfig->sensors.end(), type) !=
+            mConfig->sensors.end()) {
+            LOG(INFO) << "reading skin temperature from " << zone << " (" << type << ")";
+            mSensorPaths.push_back(zone + "/temp");
+        }
+    }
+}
+
+bool ThermalGovernor::readSkin(float* tempC) {
+    bool found = false;
+
+    for (const auto& path : mSensorPaths) {
+        std::string value;
+        int milliC;
+
+        if (!::android::base::ReadFileToString(path, &value) ||
+            !::android::base::ParseInt(::android::base::Trim(value), &milliC, kMinValidMilliC,
+                                       kMaxValidMilliC)) {
+            continue;
+        }
+
+        if (!found || milliC / 1000.0f > *tempC) {
+            *tempC = milliC / 1000.0f;
+        }
+        found = true;
+    }
+
+    return found;
+}
+
+void ThermalGovernor::setLevel(int level) {
+    auto now = steady_clock::now();
+
+    /* Take the new caps before dropping the old ones so nothing runs uncapped in between. */
+    HintManager::GetInstance()->DoHint(mConfig->levels[level]);
+
+    if (mAppliedLevel >= 0) {
+        HintManager::GetInstance()->EndHint(mConfig->levels[mAppliedLevel]);
+        mTimeAtLevel[mAppliedLevel] += duration_cast<milliseconds>(now - mLevelSince);
+        mLevelChanges++;
+    }
+
+    mAppliedLevel = level;
+    mLevelSince = now;
+}
+
+void ThermalGovernor::run() {
+    std::unique_lock<std::mutex> lock(mLock);
+    auto lastSample = steady_clock::now();
+    bool failing = false;
+
+    while (mRunning) {
+        auto now = steady_clock::now();
+        float tempC;
+
+        if (readSkin(&tempC)) {
+            int level = mController.update(tempC, duration_cast<milliseconds>(now - lastSample));
+
+            lastSample = now;
+            mLastTempC = tempC;
+            mSamples++;
+            failing = false;
+
+            if (level != mAppliedLevel) {
+                LOG(INFO) << StringPrintf("skin %.1fC (filtered %.1fC), moving to %s",
+                                          tempC, mController.filtered(),
+                                          mConfig->levels[level].c_str());
+                setLevel(level);
+            }
+        } else {
+            /* Hold the current caps, moving blind could only make things worse. */
+            if (!failing) {
+                LOG(WARNING) << "failed to read skin temperature, holding "
+                             << mConfig->levels[mAppliedLevel];
+            }
+            mReadFailures++;
+            failing = true;
+        }
+
+        mCond.wait_for(lock, mConfig->samplingInterval, [this] { return !mRunning; });
+    }
+}
+
+void ThermalGovernor::start() {
+    std::lock_guard<std::mutex> control(mControlLock);
+    std::lock_guard<std::mutex> lock(mLock);
+
+    if (mConfig->levels.empty() || mAppliedLevel >= 0) {
+        return;
+    }
+
+    /* Without feedback the first level is the static cap SUSTAINED_PERFORMANCE always had. */
+    setLevel(0);
+
+    if (!mConfig->enabled) {
+        return;
+    }
+
+    findSensors();
+    if (mSensorPaths.empty()) {
+        LOG(ERROR) << "no skin temperature sensor found, holding " << mConfig->levels[0];
+        return;
+    }
+
+    mController.reset();
+    mRunning = true;
+    mThread = std::thread(&ThermalGovernor::run, this);
+}
+
+void ThermalGovernor::stop() {
+    std::lock_guard<std::mutex> control(mControlLock);
+
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mRunning = false;
+    }
+    mCond.notify_all();
+
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mLock);
+    if (mAppliedLevel >= 0) {
+        HintManager::GetInstance()->EndHint(mConfig->levels[mAppliedLevel]);
+        mTimeAtLevel[mAppliedLevel] +=
+                duration_cast<milliseconds>(steady_clock::now() - mLevelSince);
+        mAppliedLevel = -1;
+    }
+}
+
+std::string ThermalGovernor::dump() {
+    std::lock_guard<std::mutex> lock(mLock);
+    std::string out = "Thermal governor: ";
+
+    if (!mConfig->enabled) {
+        out += "disabled\n";
+        return out;
+    }
+
+    if (mRunning) {
+        StringAppendF(&out, "skin %.1fC filtered %.1fC target %.1fC output %.2f level %s\n",
+                      mLastTempC, mController.filtered(), mConfig->targetC, mController.output(),
+                      mConfig->levels[mAppliedLevel].c_str());
+    } else {
+        out += mAppliedLevel >= 0 ? "no sensor\n" : "idle\n";
+    }
+
+    StringAppendF(&out, "samples %" PRIu64 " read failures %" PRIu64 " level changes %" PRIu64
+                        "\n",
+                  mSamples, mReadFailures, mLevelChanges);
+
+    for (size_t i = 0; i < mTimeAtLevel.size(); i++) {
+        auto spent = mTimeAtLevel[i];
+
+        if (int(i) == mAppliedLevel) {
+            spent += duration_cast<milliseconds>(steady_clock::now() - mLevelSince);
+        }
+        StringAppendF(&out, "  %s %.1fs\n", mConfig->levels[i].c_str(), spent.count() / 1000.0);
+    }
+
+    return out;
+}
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
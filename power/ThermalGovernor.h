@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ThermalConfig.h"
+#include "ThermalController.h"
+
+namespace aidl {
+namespace android {
+namespace hardware {
+namespace power {
+
+/*
+ * Holds skin temperature at the configured target while SUSTAINED_PERFORMANCE
+ * is on by moving between the cap level hints in powerhint.json, so long
+ * sessions settle at a frame rate they can keep instead of running into the
+ * kernel trip points. The hints go through libperfmgr like any other, so a
+ * boost asking for higher caps still wins while it lasts.
+ */
+class ThermalGovernor {
+  public:
+    explicit ThermalGovernor(std::shared_ptr<const ThermalConfig> config,
+                             std::string thermalRoot = "/sys/class/thermal");
+    ~ThermalGovernor();
+
+    void start();
+    void stop();
+    std::string dump();
+
+  private:
+    void run();
+    void findSensors();
+    bool readSkin(float* tempC);
+    void setLevel(int level);
+
+    const std::shared_ptr<const ThermalConfig> mConfig;
+    const std::string mThermalRoot;
+
+    /* Serializes start and stop, which drop mLock to join the thread. */
+    std::mutex mControlLock;
+    std::mutex mLock;
+    std::condition_variable mCond;
+    std::thread mThread;
+    bool mRunning;
+
+    ThermalController mController;
+    std::vector<std::string> mSensorPaths;
+    int mAppliedLevel;
+    std::chrono::steady_clock::time_point mLevelSince;
+
+    float mLastTempC;
+    uint64_t mSamples;
+    uint64_t mReadFailures;
+    uint64_t mLevelChanges;
+    std::vector<std::chrono::milliseconds> mTimeAtLevel;
+};
+
+}  // namespace power
+}  // namespace hardware
+}  // namespace android
+}  // namespace aidl
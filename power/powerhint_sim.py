@@ -0,0 +1,416 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2023 The LineageOS Project
+#
+# SPDX-License-Identifier: Apache-2.0
+#
+
+"""
+Replays power hints against powerhint.json the way libperfmgr applies
+them, without a device: prints the node timeline, how many writes it took
+and how long each node spent at each value, and checks the config for
+values no action can reach and actions that fight each other.
+
+A trace has one Power HAL call per line:
+
+  <time_ms> setBoost <BOOST> <duration_ms>
+  <time_ms> setMode <MODE> <0|1>
+  <time_ms> level <LEVEL_HINT>
+
+SUSTAINED_PERFORMANCE also takes the first of the thermal governor's
+levels, as the HAL does. level lines stand in for the governor moving to
+another level while the mode is on.
+
+`adb logcat -v epoch` output works as is once the HAL logs its calls:
+adb shell setprop log.tag.android.hardware.power-service.mt6768 V
+The governor's "moving to <LEVEL_HINT>" lines count as level lines.
+"""
+
+import argparse
+import heapq
+import itertools
+import json
+import os
+import re
+import sys
+from collections import defaultdict
+
+FOREVER = float('inf')
+
+CALL = re.compile(r'\b(setBoost|setMode)\s+(\w+)\s+(-?\d+)\s*$')
+LEVEL = re.compile(r'\b(?:level|moving to)\s+(\w+)\s*$')
+
+# The mode the thermal governor runs under, see ThermalGovernor.cpp.
+GOVERNED_MODE = 'SUSTAINED_PERFORMANCE'
+
+# Checking every combination of hints gets slow past this many.
+MAX_COMBINED_HINTS = 12
+
+
+class Node:
+    def __init__(self, config):
+        self.name = config['Name']
+        self.path = config['Path']
+        self.values = config['Values']
+        self.property = config.get('Type') == 'Property'
+        self.default = config.get('DefaultIndex', len(self.values) - 1)
+        self.reset_on_init = config.get('ResetOnInit', False)
+        # hint -> (value index, expire time)
+        self.requests = {}
+        self.current = self.default
+        self.since = 0.0
+        self.writes = 0
+        self.time_at = defaultdict(float)
+
+    def wanted(self, now):
+        """The lowest index, and so highest priority, request still active at now."""
+        active = [index for index, expire in self.requests.values() if expire > now]
+        return min(active) if active else self.default
+
+    def value(self, index=None):
+        return self.values[self.current if index is None else index]
+
+
+def numeric(value):
+    try:
+        return int(value)
+    except ValueError:
+        return None
+
+
+def freq_pairs(nodes):
+    """(floor, cap) node pairs, matched by name."""
+    return [(node, nodes[node.name.replace('MinFreq', 'MaxFreq')]) for node in nodes.values()
+            if 'MinFreq' in node.name and node.name.replace('MinFreq', 'MaxFreq') in nodes]
+
+
+def inverted(floor, cap):
+    low, high = numeric(floor), numeric(cap)
+    return low is not None and high is not None and low >= 0 and high >= 0 and low > high
+
+
+class Simulator:
+    def __init__(self, nodes, actions, levels=(), root=None):
+        self.nodes = nodes
+        self.actions = actions
+        self.levels = list(levels)
+        # Index into levels of the governor's current hint, -1 while off.
+        self.level = -1
+        self.root = root
+        self.expiries = []
+        self.timeline = []
+        self.inversions = []
+        self.inverted = set()
+        self.init_writes = 0
+        self.ignored = defaultdict(int)
+        self.ignored_levels = defaultdict(int)
+
+    def start(self):
+        for node in self.nodes.values():
+            if self.root:
+                os.makedirs(os.path.dirname(self.fake_path(node)), exist_ok=True)
+                with open(self.fake_path(node), 'w') as f:
+                    f.write(node.value())
+            if node.reset_on_init:
+                self.write(node, node.default, 0.0, 'init')
+                self.init_writes += 1
+
+    def fake_path(self, node):
+        if node.property:
+            return os.path.join(self.root, '__properties__', node.path)
+        return os.path.join(self.root, node.path.lstrip('/'))
+
+    def write(self, node, index, now, cause):
+        node.time_at[node.current] += now - node.since
+        node.current = index
+        node.since = now
+        node.writes += 1
+        self.timeline.append((now, node.name, node.value(), cause))
+
+        if self.root:
+            with open(self.fake_path(node), 'w') as f:
+                f.write(node.value())
+
+    def update(self, now, cause):
+        for node in self.nodes.values():
+            index = node.wanted(now)
+            if index != node.current:
+                self.write(node, index, now, cause)
+
+        for floor, cap in freq_pairs(self.nodes):
+            if not inverted(floor.value(), cap.value()):
+                self.inverted.discard(floor.name)
+            elif floor.name not in self.inverted:
+                self.inverted.add(floor.name)
+                self.inversions.append((now, floor.name, floor.value(), cap.name, cap.value()))
+
+    def advance(self, until):
+        """Lets timed requests run out up to and including until."""
+        while self.expiries and self.expiries[0][0] <= until:
+            expire, hint = heapq.heappop(self.expiries)
+            self.update(expire, hint + ' expired')
+
+    def do_hint(self, hint, now, override_ms=0):
+        for node, index, duration_ms in self.actions[hint]:
+            duration_ms = override_ms or duration_ms
+            expire = now + duration_ms if duration_ms > 0 else FOREVER
+            node.requests[hint] = (index, expire)
+            if expire != FOREVER:
+                heapq.heappush(self.expiries, (expire, hint))
+        self.update(now, hint)
+
+    def end_hint(self, hint, now):
+        for node, _, _ in self.actions[hint]:
+            node.requests.pop(hint, None)
+        self.update(now, hint + ' ended')
+
+    def set_level(self, level, now):
+        """Moves the governor to level, -1 to stop it, taking new caps before dropping old ones."""
+        if level >= 0:
+            self.do_hint(self.levels[level], now)
+        if self.level >= 0 and self.level != level:
+            self.end_hint(self.levels[self.level], now)
+        self.level = level
+
+    def call(self, now, method, name, arg):
+        """Applies one Power HAL call the way the HAL maps it onto libperfmgr."""
+        self.advance(now)
+
+        if method == 'level':
+            if self.level < 0 or name not in self.levels or name not in self.actions:
+                self.ignored_levels[name] += 1
+            else:
+                self.set_level(self.levels.index(name), now)
+        elif name not in self.actions:
+            self.ignored[name] += 1
+        elif method == 'setMode':
+            if arg:
+                self.do_hint(name, now)
+            else:
+                self.end_hint(name, now)
+            if name == GOVERNED_MODE and self.levels:
+                if arg and self.level < 0:
+                    self.set_level(0, now)
+                elif not arg and self.level >= 0:
+                    self.set_level(-1, now)
+        elif arg >= 0:
+            self.do_hint(name, now, arg)
+        else:
+            self.end_hint(name, now)
+
+    def finish(self, end):
+        self.advance(end)
+        for node in self.nodes.values():
+            node.time_at[node.current] += end - node.since
+            node.since = end
+
+
+def load_config(path):
+    """Returns nodes, actions per hint, governor levels and a list of (severity, message)."""
+    with open(path) as f:
+        config = json.load(f)
+
+    problems = []
+    nodes = {}
+    for entry in config['Nodes']:
+        node = Node(entry)
+        nodes[node.name] = node
+        if not 0 <= node.default < len(node.values):
+            problems.append(('error', '%s: DefaultIndex %d out of range' %
+                             (node.name, node.default)))
+            node.default = node.current = len(node.values) - 1
+        for value in set(node.values):
+            if node.values.count(value) > 1:
+                problems.append(('warning', '%s: value %s listed %d times' %
+                                 (node.name, value, node.values.count(value))))
+
+    actions = defaultdict(list)
+    for entry in config['Actions']:
+        hint, name, value = entry['PowerHint'], entry['Node'], entry['Value']
+        node = nodes.get(name)
+        if node is None:
+            problems.append(('error', '%s: unknown node %s' % (hint, name)))
+            continue
+        if value not in node.values:
+            problems.append(('error', '%s: %s has no value %s' % (hint, name, value)))
+            continue
+        for other, index, _ in actions[hint]:
+            if other is node:
+                problems.append(('warning', '%s: sets %s twice, to %s and %s' %
+                                 (hint, name, node.value(index), value)))
+        actions[hint].append((node, node.values.index(value), entry.get('Duration', 0)))
+
+    levels = config.get('ThermalGovernorConfig', {}).get('Levels', [])
+    for level in levels:
+        if level not in actions:
+            problems.append(('error', 'ThermalGovernorConfig: no hint %s' % level))
+
+    return nodes, actions, levels, problems
+
+
+def lint(nodes, actions):
+    problems = []
+
+    used = defaultdict(set)
+    for hint_actions in actions.values():
+        for node, index, _ in hint_actions:
+            used[node.name].add(index)
+
+    for node in nodes.values():
+        unreachable = [value for index, value in enumerate(node.values)
+                       if index != node.default and index not in used[node.name]]
+        if unreachable:
+            problems.append(('info', '%s: unreachable %s' % (node.name, ' '.join(unreachable))))
+
+    # A floor above its cap only shows up once the right hints overlap.
+    hints = sorted(actions)
+    if len(hints) > MAX_COMBINED_HINTS:
+        problems.append(('info', 'only checking pairs of the %d hints' % len(hints)))
+    sizes = range(1, len(hints) + 1) if len(hints) <= MAX_COMBINED_HINTS else (1, 2)
+    found = []
+    for size in sizes:
+        for combo in itertools.combinations(hints, size):
+            if any(set(smaller) <= set(combo) for smaller in found):
+                continue
+            wanted = {}
+            for hint in combo:
+                for node, index, _ in actions[hint]:
+                    wanted[node.name] = min(index, wanted.get(node.name, index))
+            for floor, cap in freq_pairs(nodes):
+                low = floor.value(wanted.get(floor.name, floor.default))
+                high = cap.value(wanted.get(cap.name, cap.default))
+                if inverted(low, high):
+                    found.append(combo)
+                    problems.append(('warning', '%s: %s %s above %s %s' %
+                                     (' + '.join(combo), floor.name, low, cap.name, high)))
+
+    return problems
+
+
+def parse_trace(lines):
+    """Returns [time_ms, method, name, arg] calls, starting at time 0."""
+    calls = []
+
+    for number, line in enumerate(lines, 1):
+        line = line.strip()
+        if not line or line.startswith('#'):
+            continue
+        match = CALL.search(line)
+        level = LEVEL.search(line) if not match else None
+        if not match and not level:
+            continue
+
+        try:
+            stamp = float(line.split()[0])
+        except ValueError:
+            sys.exit('line %d: no timestamp' % number)
+        # Anything more than the call itself is logcat, stamped in seconds.
+        if len(line.split()) > 4:
+            stamp *= 1000
+
+        if match:
+            calls.append([stamp, match.group(1), match.group(2), int(match.group(3))])
+        else:
+            calls.append([stamp, 'level', level.group(1), 0])
+
+    calls.sort(key=lambda call: call[0])
+    if calls:
+        first = calls[0][0]
+        for call in calls:
+            call[0] -= first
+
+    return calls
+
+
+def report(sim, nodes, end, show_timeline):
+    if show_timeline:
+        print('timeline:')
+        for now, name, value, cause in sim.timeline:
+            print('  %10.1f ms  %-26s %-22s %s' % (now, name, value or '""', cause))
+        print()
+
+    print('writes: %d over %.1f ms, %d of them at init' %
+          (sum(node.writes for node in nodes.values()), end, sim.init_writes))
+    for node in nodes.values():
+        if len(node.time_at) <= 1:
+            continue
+        print('  %-26s %4d writes' % (node.name, node.writes))
+        for index, spent in sorted(node.time_at.items()):
+            if spent > 0:
+                print('      %-22s %10.1f ms %5.1f%%' %
+                      (node.value(index) or '""', spent, 100 * spent / end if end else 0))
+
+    for name, count in sorted(sim.ignored.items()):
+        print('ignored %d calls to %s, not in powerhint.json' % (count, name))
+    for name, count in sorted(sim.ignored_levels.items()):
+        print('ignored %d moves to %s, not a level or %s is off' % (count, name, GOVERNED_MODE))
+
+    for now, floor, low, cap, high in sim.inversions:
+        print('%.1f ms: %s %s above %s %s' % (now, floor, low, cap, high))
+
+
+def counters(nodes, sim):
+    """Chrome JSON counter tracks, one per node with numeric values."""
+    trace = []
+
+    for node in nodes.values():
+        if node.writes == 0 or numeric(node.value(node.default)) is None:
+            continue
+        trace.append({'name': node.name, 'ph': 'C', 'ts': 0, 'pid': 0,
+                      'args': {'value': numeric(node.value(node.default))}})
+
+    for now, name, value, _ in sim.timeline:
+        if numeric(value) is not None:
+            trace.append({'name': name, 'ph': 'C', 'ts': now * 1e3, 'pid': 0,
+                          'args': {'value': numeric(value)}})
+
+    return {'traceEvents': trace, 'displayTimeUnit': 'ms'}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__,
+                                     formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('config', help='powerhint.json')
+    parser.add_argument('trace', nargs='?', help='calls to replay, only lints without one')
+    parser.add_argument('--root', help='mirror node writes into a fake sysfs tree here')
+    parser.add_argument('--until', type=float, help='stop at this time in ms, '
+                        'default is when the last timed request runs out')
+    parser.add_argument('--timeline', action='store_true', help='print every node write')
+    parser.add_argument('--json', help='write node values as a Chrome JSON timeline')
+    args = parser.parse_args()
+
+    nodes, actions, levels, problems = load_config(args.config)
+    problems += lint(nodes, actions)
+    for severity, message in problems:
+        print('%s: %s' % (severity, message))
+
+    if args.trace:
+        with open(args.trace) as f:
+            calls = parse_trace(f)
+
+        sim = Simulator(nodes, actions, levels, args.root)
+        sim.start()
+        for now, method, name, arg in calls:
+            if args.until is not None and now > args.until:
+                break
+            sim.call(now, method, name, arg)
+
+        end = args.until
+        if end is None:
+            last = calls[-1][0] if calls else 0.0
+            end = max([last] + [expire for expire, _ in sim.expiries])
+        sim.finish(end)
+
+        print()
+        report(sim, nodes, end, args.timeline)
+
+        if args.json:
+            with open(args.json, 'w') as f:
+                json.dump(counters(nodes, sim), f)
+
+    if any(severity == 'error' for severity, _ in problems):
+        sys.exit(1)
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define LOG_TAG "android.hardware.power-service.mt6768"
+
+#include <android-base/logging.h>
+#include <android/binder_manager.h>
+#include <android/binder_process.h>
+#include <perfmgr/HintManager.h>
+
+#include "AdpfConfig.h"
+#include "Power.h"
+#include "PowerExt.h"
+#include "ThermalConfig.h"
+#include "ThermalGovernor.h"
+
+#define POWERHINT_CONFIG "/vendor/etc/powerhint.json"
+
+using aidl::android::hardware::power::AdpfConfig;
+using aidl::android::hardware::power::Power;
+using aidl::android::hardware::power::ThermalConfig;
+using aidl::android::hardware::power::ThermalGovernor;
+using aidl::google::hardware::power::extension::pixel::PowerExt;
+using android::perfmgr::HintManager;
+
+int main() {
+    /* Parses powerhint.json, Power starts the looper once boot completes. */
+    if (HintManager::GetInstance() == nullptr) {
+        LOG(FATAL) << "invalid libperfmgr config";
+    }
+
+    auto adpfConfig = std::make_shared<AdpfConfig>();
+    if (!adpfConfig->load(POWERHINT_CONFIG)) {
+        LOG(ERROR) << "hint sessions disabled";
+        adpfConfig->enabled = false;
+    }
+
+    auto thermalConfig = std::make_shared<ThermalConfig>();
+    if (!thermalConfig->load(POWERHINT_CONFIG)) {
+        LOG(ERROR) << "thermal governor disabled";
+        thermalConfig->enabled = false;
+    }
+    for (const auto& level : thermalConfig->levels) {
+        if (!HintManager::GetInstance()->IsHintSupported(level)) {
+            LOG(ERROR) << "thermal governor disabled, no hint " << level;
+            thermalConfig->enabled = false;
+        }
+    }
+    auto thermalGovernor = std::make_shared<ThermalGovernor>(thermalConfig);
+
+    ABinderProcess_setThreadPoolMaxThreadCount(0);
+
+    std::shared_ptr<Power> power = ndk::SharedRefBase::make<Power>(adpfConfig, thermalGovernor);
+    std::shared_ptr<PowerExt> powerExt = ndk::SharedRefBase::make<PowerExt>(power->ready());
+    CHECK_EQ(AIBinder_setExtension(power->asBinder().get(), powerExt->asBinder().get()), STATUS_OK);
+
+    const std::string instance = std::string(Power::descriptor) + "/default";
+    binder_status_t status = AServiceManager_addService(power->asBinder().get(), instance.c_str());
+    CHECK_EQ(status, STATUS_OK);
+
+    ABinderProcess_joinThreadPool();
+    return EXIT_FAILURE;  // should not reach
+}
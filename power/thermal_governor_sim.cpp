@@ -0,0 +1,258 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Runs the SUSTAINED_PERFORMANCE thermal controller on a host, either
+ * replaying a recorded skin temperature trace or closing the loop over a
+ * first-order model of the phone heating up:
+ *
+ *   thermal_governor_sim --trace skin.txt powerhint.json
+ *   thermal_governor_sim --plant 25,300,24,10 --duration 1800 powerhint.json
+ *
+ * A trace has one "<seconds> <celsius>" reading per line. The model settles
+ * at ambient plus a rise that goes from the first to the last value as the
+ * caps tighten, with the given time constant in seconds.
+ */
+
+#include <android-base/logging.h>
+#include <android-base/parsedouble.h>
+#include <android-base/strings.h>
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+
+#include "ThermalConfig.h"
+#include "ThermalController.h"
+
+using aidl::android::hardware::power::ThermalConfig;
+using aidl::android::hardware::power::ThermalController;
+using std::chrono::milliseconds;
+
+namespace {
+
+struct Plant {
+    double ambientC;
+    double tauS;
+    double riseFirst;
+    double riseLast;
+};
+
+class Stats {
+  public:
+    Stats(const ThermalConfig& config, bool csv)
+        : mConfig(config), mCsv(csv), mTimeAt(config.levels.size()) {
+        if (mCsv) {
+            printf("time_s,skin_c,filtered_c,output,level\n");
+        }
+    }
+
+    void add(double timeS, double tempC, const ThermalController& controller) {
+        double dt = mReadings.empty() ? 0 : timeS - mReadings.back().first;
+
+        if (!mReadings.empty()) {
+            mTimeAt[mLevel] += dt;
+            if (mReadings.back().second > mConfig.targetC + 1) {
+                mAboveS += dt;
+            }
+        }
+        if (!mReadings.empty() && controller.level() != mLevel) {
+            mChanges++;
+        }
+
+        mLevel = controller.level();
+        mMaxC = mReadings.empty() ? tempC : std::max(mMaxC, tempC);
+        mReadings.emplace_back(timeS, tempC);
+
+        if (mCsv) {
+            printf("%.1f,%.2f,%.2f,%.3f,%d\n", timeS, tempC, controller.filtered(),
+                   controller.output(), mLevel);
+        }
+    }
+
+    void report() const {
+        if (mReadings.empty()) {
+            return;
+        }
+
+        double end = mReadings.back().first;
+        double errorSum = 0;
+        size_t errorCount = 0;
+
+        for (const auto& [timeS, tempC] : mReadings) {
+            if (timeS >= end / 2) {
+                errorSum += std::fabs(tempC - mConfig.targetC);
+                errorCount++;
+            }
+        }
+
+        FILE* out = mCsv ? stderr : stdout;
+        fprintf(out, "%zu samples over %.0fs, target %.1fC\n", mReadings.size(), end,
+                mConfig.targetC);
+        fprintf(out, "skin max %.1fC, mean error %.2fC over the second half, %.0fs above %.1fC\n",
+                mMaxC, errorSum / errorCount, mAboveS, mConfig.targetC + 1);
+        fprintf(out, "%d level changes\n", mChanges);
+        for (size_t i = 0; i < mTimeAt.size(); i++) {
+            if (mTimeAt[i] > 0) {
+                fprintf(out, "  %-28s %8.0fs %5.1f%%\n", mConfig.levels[i].c_str(), mTimeAt[i],
+                        end > 0 ? 100 * mTimeAt[i] / end : 0);
+            }
+        }
+    }
+
+  private:
+    const ThermalConfig& mConfig;
+    const bool mCsv;
+    std::vector<std::pair<double, double>> mReadings;
+    std::vector<double> mTimeAt;
+    double mMaxC = 0;
+    double mAboveS = 0;
+    int mChanges = 0;
+    int mLevel = 0;
+};
+
+bool parsePlant(const std::string& arg, Plant* plant) {
+    auto values = android::base::Split(arg, ",");
+
+    return values.size() == 4 && android::base::ParseDouble(values[0], &plant->ambientC) &&
+           android::base::ParseDouble(values[1], &plant->tauS, 1.0) &&
+           android::base::ParseDouble(values[2], &plant->riseFirst) &&
+           android::base::ParseDouble(values[3], &plant->riseLast);
+}
+
+bool replay(const std::string& path, ThermalController& controller, Stats& stats) {
+    std::ifstream trace(path);
+    std::string line;
+    double lastS = 0;
+    bool first = true;
+
+    if (!trace) {
+        PLOG(ERROR) << "failed to open " << path;
+        return false;
+    }
+
+    while (std::getline(trace, line)) {
+        auto fields = android::base::Tokenize(line, " \t,");
+        double timeS, tempC;
+
+        if (fields.empty() || android::base::StartsWith(fields[0], "#")) {
+            continue;
+        }
+        if (fields.size() < 2 || !android::base::ParseDouble(fields[0], &timeS) ||
+            !android::base::ParseDouble(fields[1], &tempC) || (!first && timeS < lastS)) {
+            LOG(ERROR) << "bad reading in " << path << ": " << line;
+            return false;
+        }
+
+        controller.update(tempC, milliseconds(first ? 0 : std::lround((timeS - lastS) * 1000)));
+        stats.add(timeS, tempC, controller);
+        lastS = timeS;
+        first = false;
+    }
+
+    return true;
+}
+
+void simulate(const Plant& plant, double startC, double noiseC, double durationS,
+              const ThermalConfig& config, ThermalController& controller, Stats& stats) {
+    double stepS = config.samplingInterval.count() / 1000.0;
+    double decay = 1 - std::exp(-stepS / plant.tauS);
+    int maxLevel = std::max(int(config.levels.size()) - 1, 1);
+    std::mt19937 random(1);
+    std::normal_distribution<double> noise(0, noiseC > 0 ? noiseC : 1);
+    double skinC = startC;
+
+    for (double timeS = 0; timeS <= durationS; timeS += stepS) {
+        /* Sensors report whole millidegrees. */
+        double readingC = std::round((skinC + (noiseC > 0 ? noise(random) : 0)) * 1000) / 1000;
+        int level = controller.update(readingC, milliseconds(timeS > 0 ? std::lround(stepS * 1000)
+                                                                       : 0));
+        double rise = plant.riseFirst + (plant.riseLast - plant.riseFirst) * level / maxLevel;
+
+        stats.add(timeS, readingC, controller);
+        skinC += (plant.ambientC + rise - skinC) * decay;
+    }
+}
+
+void usage(const char* name) {
+    fprintf(stderr,
+            "usage: %s [--target C] [--csv] (--trace FILE | --plant AMBIENT,TAU,RISE_FIRST,"
+            "RISE_LAST [--start C] [--noise C] [--duration S]) powerhint.json\n",
+            name);
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+    std::string tracePath, configPath;
+    Plant plant;
+    bool havePlant = false, csv = false;
+    double targetC = NAN, startC = NAN, noiseC = 0, durationS = 1800;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool ok = true;
+
+        if (arg == "--csv") {
+            csv = true;
+        } else if (!android::base::StartsWith(arg, "--")) {
+            ok = configPath.empty();
+            configPath = arg;
+        } else if (i + 1 >= argc) {
+            ok = false;
+        } else if (arg == "--trace") {
+            tracePath = argv[++i];
+        } else if (arg == "--plant") {
+            ok = havePlant = parsePlant(argv[++i], &plant);
+        } else if (arg == "--target") {
+            ok = android::base::ParseDouble(argv[++i], &targetC);
+        } else if (arg == "--start") {
+            ok = android::base::ParseDouble(argv[++i], &startC);
+        } else if (arg == "--noise") {
+            ok = android::base::ParseDouble(argv[++i], &noiseC, 0.0);
+        } else if (arg == "--duration") {
+            ok = android::base::ParseDouble(argv[++i], &durationS, 0.0);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (configPath.empty() || tracePath.empty() == !havePlant) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    ThermalConfig config;
+    if (!config.load(configPath)) {
+        return 1;
+    }
+    if (config.levels.empty()) {
+        LOG(ERROR) << "no thermal levels in " << configPath;
+        return 1;
+    }
+    if (!std::isnan(targetC)) {
+        config.targetC = targetC;
+    }
+
+    ThermalController controller(config);
+    Stats stats(config, csv);
+
+    if (havePlant) {
+        simulate(plant, std::isnan(startC) ? plant.ambientC : startC, noiseC, durationS, config,
+                 controller, stats);
+    } else if (!replay(tracePath, controller, stats)) {
+        return 1;
+    }
+
+    stats.report();
+    return 0;
+}
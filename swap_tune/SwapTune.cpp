@@ -0,0 +1,411 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SwapTune.h"
+
+#include <android-base/file.h>
+#include <android-base/logging.h>
+#include <android-base/parseint.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using ::android::base::ParseUint;
+using ::android::base::ReadFileToString;
+using ::android::base::Split;
+using ::android::base::StringPrintf;
+using ::android::base::Trim;
+using ::android::base::WriteStringToFile;
+using std::chrono::duration_cast;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+constexpr uint64_t kMiB = 1024 * 1024;
+constexpr uint64_t kPageSize = 4096;
+
+static bool readTrimmed(const std::string& path, std::string* value) {
+    if (!ReadFileToString(path, value)) {
+        return false;
+    }
+
+    *value = Trim(*value);
+    return true;
+}
+
+static bool parseSeconds(const std::string& value, seconds* out) {
+    uint32_t count;
+
+    if (!ParseUint(value, &count)) {
+        return false;
+    }
+
+    *out = seconds(count);
+    return true;
+}
+
+}  // anonymous namespace
+
+bool SwapTuneConfig::load(const std::string& path) {
+    std::string content;
+
+    if (!ReadFileToString(path, &content)) {
+        return false;
+    }
+
+    for (const auto& rawLine : Split(content, "\n")) {
+        std::string line = Trim(rawLine);
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+
+        size_t split = line.find_first_of(" \t");
+        std::string key = line.substr(0, split);
+        std::string value = split == std::string::npos ? "" : Trim(line.substr(split));
+        bool ok = true;
+
+        if (value.empty()) {
+            ok = false;
+        } else if (key == "psi_path") {
+            psiPath = value;
+        } else if (key == "meminfo_path") {
+            meminfoPath = value;
+        } else if (key == "swappiness_path") {
+            swappinessPath = value;
+        } else if (key == "zram_path") {
+            zramPath = value;
+        } else if (key == "tier") {
+            tier = value;
+        } else if (key == "comp_algorithm") {
+            defaultCompAlgorithm = value;
+        } else if (android::base::StartsWith(key, "comp_algorithm.")) {
+            compAlgorithms[key.substr(strlen("comp_algorithm."))] = value;
+        } else if (key == "swappiness_min") {
+            ok = ParseUint(value, &swappinessMin, 200u);
+        } else if (key == "swappiness_max") {
+            ok = ParseUint(value, &swappinessMax, 200u);
+        } else if (key == "swappiness_step") {
+            ok = ParseUint(value, &swappinessStep, 200u);
+        } else if (key == "psi_low") {
+            psiLow = strtof(value.c_str(), nullptr);
+        } else if (key == "psi_high") {
+            psiHigh = strtof(value.c_str(), nullptr);
+        } else if (key == "psi_trigger") {
+            psiTrigger = value;
+        } else if (key == "swap_full_percent") {
+            ok = ParseUint(value, &swapFullPercent, 100u);
+        } else if (key == "poll_interval_s") {
+            ok = parseSeconds(value, &pollInterval);
+        } else if (key == "stats_interval_s") {
+            ok = parseSeconds(value, &statsInterval);
+        } else if (key == "writeback_interval_s") {
+            ok = parseSeconds(value, &writebackInterval);
+        } else if (key == "writeback_max_mb") {
+            ok = ParseUint(value, &writebackMaxMb);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            LOG(WARNING) << "ignoring malformed line in " << path << ": " << line;
+        }
+    }
+
+    if (swappinessMin > swappinessMax) {
+        LOG(WARNING) << "swappiness_min is above swappiness_max, pinning to " << swappinessMax;
+        swappinessMin = swappinessMax;
+    }
+
+    LOG(INFO) << "loaded config from " << path;
+    return true;
+}
+
+SwapTune::SwapTune(const SwapTuneConfig& config)
+    : mConfig(config),
+      mSwappiness(config.swappinessMax),
+      mLastStats(),
+      mLastIdleMark(),
+      mIdleMarked(false) {
+    std::string current;
+    uint32_t swappiness;
+
+    if (mConfig.tier.empty()) {
+        mConfig.tier = ::android::base::GetProperty("ro.vendor.ram_tier", "");
+    }
+
+    if (readTrimmed(mConfig.swappinessPath, &current) && ParseUint(current, &swappiness)) {
+        mSwappiness = swappiness;
+    }
+}
+
+void SwapTune::configureZram() {
+    auto it = mConfig.compAlgorithms.find(mConfig.tier);
+    std::string algorithm =
+            it != mConfig.compAlgorithms.end() ? it->second : mConfig.defaultCompAlgorithm;
+    std::string available, disksize;
+
+    /*
+     * The algorithm can only change while the device is unsized, and only
+     * to one the kernel lists, e.g. "lzo [lz4] zstd".
+     */
+    if (!readTrimmed(zramAttr("comp_algorithm"), &available)) {
+        PLOG(ERROR) << "failed to read " << zramAttr("comp_algorithm");
+    } else if (readTrimmed(zramAttr("disksize"), &disksize) && disksize != "0") {
+        LOG(WARNING) << "zram already sized, keeping " << available;
+    } else {
+        std::vector<std::string> names = Split(available, " ");
+        bool found = std::any_of(names.begin(), names.end(), [&](const std::string& name) {
+            return name == algorithm || name == "[" + algorithm + "]";
+        });
+
+        if (!found) {
+            LOG(WARNING) << "zram has no " << algorithm << ", keeping " << available;
+        } else if (!WriteStringToFile(algorithm, zramAttr("comp_algorithm"))) {
+            PLOG(ERROR) << "failed to set zram algorithm " << algorithm;
+        } else {
+            LOG(INFO) << "tier " << mConfig.tier << ": zram algorithm " << algorithm
+                      << ", size "
+                      << ::android::base::GetProperty("ro.vendor.zram.size_percent", "50")
+                      << "% of RAM";
+        }
+    }
+
+    setSwappiness(mConfig.swappinessMax, "boot");
+}
+
+bool SwapTune::readPressure(Pressure* pressure) {
+    std::string content;
+
+    if (!ReadFileToString(mConfig.psiPath, &content)) {
+        return false;
+    }
+
+    *pressure = {};
+    for (const auto& line : Split(content, "\n")) {
+        float avg10, avg60, avg300;
+        uint64_t total;
+
+        if (sscanf(line.c_str(), "%*s avg10=%f avg60=%f avg300=%f total=%" SCNu64, &avg10,
+                   &avg60, &avg300, &total) != 4) {
+            continue;
+        }
+
+        if (android::base::StartsWith(line, "some")) {
+            pressure->someAvg10 = avg10;
+            pressure->someAvg60 = avg60;
+            pressure->someTotal = total;
+        } else if (android::base::StartsWith(line, "full")) {
+            pressure->fullAvg10 = avg10;
+            pressure->fullAvg60 = avg60;
+            pressure->fullTotal = total;
+        }
+    }
+
+    return true;
+}
+
+bool SwapTune::readSwap(SwapUsage* swap) {
+    std::string content;
+
+    if (!ReadFileToString(mConfig.meminfoPath, &content)) {
+        return false;
+    }
+
+    *swap = {};
+    for (const auto& line : Split(content, "\n")) {
+        sscanf(line.c_str(), "SwapTotal: %" SCNu64, &swap->totalKb);
+        sscanf(line.c_str(), "SwapFree: %" SCNu64, &swap->freeKb);
+    }
+
+    return true;
+}
+
+bool SwapTune::setSwappiness(uint32_t value, const char* reason) {
+    if (!WriteStringToFile(std::to_string(value), mConfig.swappinessPath)) {
+        PLOG(ERROR) << "failed to set swappiness " << value;
+        return false;
+    }
+
+    LOG(INFO) << "swappiness " << mSwappiness << " -> " << value << ": " << reason;
+    mSwappiness = value;
+    return true;
+}
+
+bool SwapTune::hasBackingDev() {
+    std::string backingDev;
+
+    return readTrimmed(zramAttr("backing_dev"), &backingDev) && backingDev != "none";
+}
+
+int SwapTune::openPressureTrigger() {
+    if (mConfig.psiTrigger == "none") {
+        return -1;
+    }
+
+    int fd = open(mConfig.psiPath.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+
+    if (fd < 0) {
+        PLOG(WARNING) << "failed to open " << mConfig.psiPath << ", polling only";
+        return -1;
+    }
+
+    /* The kernel wants the terminating NUL as part of the trigger. */
+    if (write(fd, mConfig.psiTrigger.c_str(), mConfig.psiTrigger.size() + 1) < 0) {
+        PLOG(WARNING) << "failed to arm psi trigger \"" << mConfig.psiTrigger
+                      << "\", polling only";
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+void SwapTune::adjustSwappiness(const Pressure& pressure, const SwapUsage& swap) {
+    uint32_t used = swap.usedPercent();
+    uint32_t target = mSwappiness;
+
+    /*
+     * Swapping to zram is the cheap way out of memory pressure until zram
+     * itself fills up, after which every swap-out just burns CPU on
+     * compression and dropping page cache is the better deal.
+     */
+    if (pressure.someAvg10 >= mConfig.psiHigh && used >= mConfig.swapFullPercent) {
+        target = mSwappiness > mConfig.swappinessMin + mConfig.swappinessStep
+                         ? mSwappiness - mConfig.swappinessStep
+                         : mConfig.swappinessMin;
+    } else if (pressure.someAvg10 <= mConfig.psiLow || used < mConfig.swapFullPercent) {
+        target = std::min(mSwappiness + mConfig.swappinessStep, mConfig.swappinessMax);
+    }
+
+    if (target != mSwappiness) {
+        setSwappiness(target, StringPrintf("memory stall %.2f%% with swap %u%% full",
+                                           pressure.someAvg10, used)
+                                      .c_str());
+    }
+}
+
+void SwapTune::maybeWriteback(const Pressure& pressure, steady_clock::time_point now) {
+    if (!hasBackingDev()) {
+        return;
+    }
+
+    /*
+     * Pages still marked idle one interval after marking them haven't been
+     * touched since, so those are what gets written back.
+     */
+    if (!mIdleMarked) {
+        mIdleMarked = WriteStringToFile("all", zramAttr("idle"));
+        mLastIdleMark = now;
+        return;
+    }
+
+    if (now - mLastIdleMark < mConfig.writebackInterval || pressure.someAvg10 < mConfig.psiHigh) {
+        return;
+    }
+
+    std::string before, after;
+    uint64_t writesBefore = 0, writesAfter = 0;
+
+    if (access(zramAttr("writeback_limit").c_str(), F_OK) == 0) {
+        WriteStringToFile("1", zramAttr("writeback_limit_enable"));
+        WriteStringToFile(std::to_string(mConfig.writebackMaxMb * kMiB / kPageSize),
+                          zramAttr("writeback_limit"));
+    }
+
+    readTrimmed(zramAttr("bd_stat"), &before);
+    if (!WriteStringToFile("idle", zramAttr("writeback"))) {
+        PLOG(ERROR) << "zram writeback failed";
+    }
+    readTrimmed(zramAttr("bd_stat"), &after);
+
+    /* bd_stat is "bd_count bd_reads bd_writes" in pages. */
+    sscanf(before.c_str(), "%*u %*u %" SCNu64, &writesBefore);
+    sscanf(after.c_str(), "%*u %*u %" SCNu64, &writesAfter);
+
+    LOG(INFO) << "writeback at memory stall " << StringPrintf("%.2f%%", pressure.someAvg10)
+              << ": " << (writesAfter - writesBefore) * kPageSize / kMiB << " MiB written";
+
+    mIdleMarked = WriteStringToFile("all", zramAttr("idle"));
+    mLastIdleMark = now;
+}
+
+void SwapTune::logStats(const Pressure& pressure, const SwapUsage& swap) {
+    std::string mmStat;
+    uint64_t orig = 0, compr = 0, used = 0;
+
+    /* mm_stat starts with orig_data_size compr_data_size mem_used_total. */
+    if (readTrimmed(zramAttr("mm_stat"), &mmStat)) {
+        sscanf(mmStat.c_str(), "%" SCNu64 " %" SCNu64 " %" SCNu64, &orig, &compr, &used);
+    }
+
+    LOG(INFO) << StringPrintf(
+            "stats tier=%s swappiness=%u some=%.2f/%.2f full=%.2f/%.2f stall_ms=%" PRIu64
+            "/%" PRIu64 " swap=%" PRIu64 "/%" PRIu64 "MiB zram=%" PRIu64 "/%" PRIu64
+            "/%" PRIu64 "MiB",
+            mConfig.tier.c_str(), mSwappiness, pressure.someAvg10, pressure.someAvg60,
+            pressure.fullAvg10, pressure.fullAvg60, pressure.someTotal / 1000,
+            pressure.fullTotal / 1000, (swap.totalKb - swap.freeKb) / 1024, swap.totalKb / 1024,
+            orig / kMiB, compr / kMiB, used / kMiB);
+}
+
+void SwapTune::run() {
+    ::android::base::unique_fd trigger(openPressureTrigger());
+
+    LOG(INFO) << "watching " << mConfig.psiPath << ", swappiness " << mSwappiness << " within ["
+              << mConfig.swappinessMin << ", " << mConfig.swappinessMax << "]";
+
+    mLastStats = steady_clock::now() - mConfig.statsInterval;
+
+    for (;;) {
+        pollfd fd = {trigger.get(), POLLPRI, 0};
+        int timeout = int(duration_cast<milliseconds>(mConfig.pollInterval).count());
+
+        if (trigger.get() >= 0) {
+            if (poll(&fd, 1, timeout) < 0 && errno != EINTR) {
+                PLOG(ERROR) << "failed to wait for psi events";
+            }
+            if (fd.revents & POLLERR) {
+                LOG(WARNING) << "psi trigger went away, polling only";
+                trigger.reset();
+            }
+        } else {
+            usleep(timeout * 1000);
+        }
+
+        step(steady_clock::now());
+    }
+}
+
+bool SwapTune::step(steady_clock::time_point now) {
+    Pressure pressure;
+    SwapUsage swap;
+
+    if (!readPressure(&pressure) || !readSwap(&swap)) {
+        PLOG(ERROR) << "failed to read memory pressure";
+        return false;
+    }
+
+    adjustSwappiness(pressure, swap);
+    maybeWriteback(pressure, now);
+
+    if (now - mLastStats >= mConfig.statsInterval) {
+        logStats(pressure, swap);
+        mLastStats = now;
+    }
+
+    return true;
+}
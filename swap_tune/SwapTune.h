@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <string>
+
+#define SWAP_TUNE_CONF "/vendor/etc/swap_tune.conf"
+
+struct SwapTuneConfig {
+    /* Paths, point these elsewhere to run on a plain Linux box. */
+    std::string psiPath = "/proc/pressure/memory";
+    std::string meminfoPath = "/proc/meminfo";
+    std::string swappinessPath = "/proc/sys/vm/swappiness";
+    std::string zramPath = "/sys/block/zram0";
+
+    /* RAM tier, taken from ro.vendor.ram_tier when empty. */
+    std::string tier;
+    std::map<std::string, std::string> compAlgorithms = {{"2g", "zstd"}, {"3g", "zstd"}};
+    std::string defaultCompAlgorithm = "lz4";
+
+    uint32_t swappinessMin = 60;
+    uint32_t swappinessMax = 100;
+    uint32_t swappinessStep = 10;
+
+    /* Thresholds on the 10s "some" memory stall average, in percent. */
+    float psiLow = 5;
+    float psiHigh = 20;
+    /* Stall in us over a window in us that wakes us up early, or "none". */
+    std::string psiTrigger = "some 150000 1000000";
+
+    /* Swap usage above which swapping harder stops paying off. */
+    uint32_t swapFullPercent = 80;
+
+    std::chrono::seconds pollInterval{10};
+    std::chrono::seconds statsInterval{600};
+    std::chrono::seconds writebackInterval{1800};
+    uint32_t writebackMaxMb = 128;
+
+    bool load(const std::string& path);
+};
+
+class SwapTune {
+  public:
+    explicit SwapTune(const SwapTuneConfig& config);
+
+    /* Boot time setup, must run before zram is sized by swapon_all. */
+    void configureZram();
+
+    /* Watch memory pressure until killed. */
+    void run();
+
+    /* One look at memory pressure, run() calls this on every wakeup. */
+    bool step(std::chrono::steady_clock::time_point now);
+
+    uint32_t swappiness() const { return mSwappiness; }
+
+  private:
+    struct Pressure {
+        float someAvg10;
+        float someAvg60;
+        float fullAvg10;
+        float fullAvg60;
+        uint64_t someTotal;
+        uint64_t fullTotal;
+    };
+
+    struct SwapUsage {
+        uint64_t totalKb;
+        uint64_t freeKb;
+
+        uint32_t usedPercent() const {
+            return totalKb ? uint32_t((totalKb - freeKb) * 100 / totalKb) : 0;
+        }
+    };
+
+    bool readPressure(Pressure* pressure);
+    bool readSwap(SwapUsage* swap);
+    bool setSwappiness(uint32_t value, const char* reason);
+    bool hasBackingDev();
+    int openPressureTrigger();
+
+    void adjustSwappiness(const Pressure& pressure, const SwapUsage& swap);
+    void maybeWriteback(const Pressure& pressure, std::chrono::steady_clock::time_point now);
+    void logStats(const Pressure& pressure, const SwapUsage& swap);
+
+    std::string zramAttr(const char* name) const { return mConfig.zramPath + "/" + name; }
+
+    SwapTuneConfig mConfig;
+    uint32_t mSwappiness;
+    std::chrono::steady_clock::time_point mLastStats;
+    std::chrono::steady_clock::time_point mLastIdleMark;
+    bool mIdleMarked;
+};
@@ -0,0 +1,208 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SwapTune.h"
+
+#include <android-base/file.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+#include <gtest/gtest.h>
+
+#include <cinttypes>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using ::android::base::ReadFileToString;
+using ::android::base::StringPrintf;
+using ::android::base::Trim;
+using ::android::base::WriteStringToFile;
+using std::chrono::seconds;
+using std::chrono::steady_clock;
+
+// Runs the daemon against a fake /proc and zram sysfs directory
+class SwapTuneTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mConfig.psiPath = path("pressure");
+        mConfig.meminfoPath = path("meminfo");
+        mConfig.swappinessPath = path("swappiness");
+        mConfig.zramPath = path("zram0");
+        mConfig.tier = "2g";
+        mConfig.psiTrigger = "none";
+
+        ASSERT_EQ(mkdir(mConfig.zramPath.c_str(), 0700), 0);
+        write("zram0/comp_algorithm", "lzo [lz4] zstd");
+        write("zram0/disksize", "0");
+        write("zram0/backing_dev", "none");
+        write("zram0/mm_stat", "0 0 0 0 0 0 0 0 0");
+        write("swappiness", "100");
+        setPressure(0);
+        setSwap(1024 * 1024, 1024 * 1024);
+    }
+
+    std::string path(const char* name) { return std::string(mDir.path) + "/" + name; }
+
+    void write(const char* name, const std::string& value) {
+        ASSERT_TRUE(WriteStringToFile(value, path(name)));
+    }
+
+    std::string read(const char* name) {
+        std::string value;
+
+        EXPECT_TRUE(ReadFileToString(path(name), &value));
+        return Trim(value);
+    }
+
+    void setPressure(float some) {
+        write("pressure", StringPrintf("some avg10=%.2f avg60=0.00 avg300=0.00 total=1000\n"
+                                       "full avg10=0.00 avg60=0.00 avg300=0.00 total=0\n",
+                                       some));
+    }
+
+    void setSwap(uint64_t totalKb, uint64_t freeKb) {
+        write("meminfo", StringPrintf("MemTotal:        2897152 kB\n"
+                                      "SwapTotal:       %8" PRIu64 " kB\n"
+                                      "SwapFree:        %8" PRIu64 " kB\n",
+                                      totalKb, freeKb));
+    }
+
+    TemporaryDir mDir;
+    SwapTuneConfig mConfig;
+};
+
+TEST_F(SwapTuneTest, BootPicksTierAlgorithm) {
+    write("swappiness", "60");
+
+    SwapTune(mConfig).configureZram();
+
+    EXPECT_EQ(read("zram0/comp_algorithm"), "zstd");
+    EXPECT_EQ(read("swappiness"), "100");
+}
+
+TEST_F(SwapTuneTest, BootFallsBackToDefaultAlgorithm) {
+    mConfig.tier = "6g";
+
+    SwapTune(mConfig).configureZram();
+
+    EXPECT_EQ(read("zram0/comp_algorithm"), "lz4");
+}
+
+TEST_F(SwapTuneTest, BootKeepsSizedZram) {
+    write("zram0/disksize", "1073741824");
+
+    SwapTune(mConfig).configureZram();
+
+    EXPECT_EQ(read("zram0/comp_algorithm"), "lzo [lz4] zstd");
+}
+
+TEST_F(SwapTuneTest, BootKeepsUnknownAlgorithm) {
+    write("zram0/comp_algorithm", "lzo [lz4]");
+
+    SwapTune(mConfig).configureZram();
+
+    EXPECT_EQ(read("zram0/comp_algorithm"), "lzo [lz4]");
+}
+
+TEST_F(SwapTuneTest, FullSwapUnderPressureBacksOff) {
+    SwapTune tune(mConfig);
+    auto now = steady_clock::now();
+
+    setPressure(30);
+    setSwap(1024 * 1024, 100 * 1024);
+
+    for (uint32_t expected : {90, 80, 70, 60, 60}) {
+        ASSERT_TRUE(tune.step(now));
+        EXPECT_EQ(tune.swappiness(), expected);
+        EXPECT_EQ(read("swappiness"), std::to_string(expected));
+    }
+}
+
+TEST_F(SwapTuneTest, RoomInSwapRaisesSwappiness) {
+    write("swappiness", "60");
+
+    SwapTune tune(mConfig);
+    auto now = steady_clock::now();
+
+    EXPECT_EQ(tune.swappiness(), 60u);
+
+    /* Stalling, but zram still has room to take more. */
+    setPressure(30);
+    setSwap(1024 * 1024, 512 * 1024);
+
+    for (uint32_t expected : {70, 80, 90, 100, 100}) {
+        ASSERT_TRUE(tune.step(now));
+        EXPECT_EQ(read("swappiness"), std::to_string(expected));
+    }
+}
+
+TEST_F(SwapTuneTest, ModeratePressureHolds) {
+    SwapTune tune(mConfig);
+
+    setPressure(10);
+    setSwap(1024 * 1024, 100 * 1024);
+
+    ASSERT_TRUE(tune.step(steady_clock::now()));
+    EXPECT_EQ(tune.swappiness(), 100u);
+}
+
+TEST_F(SwapTuneTest, MissingPressureFileFails) {
+    SwapTune tune(mConfig);
+
+    unlink(path("pressure").c_str());
+
+    EXPECT_FALSE(tune.step(steady_clock::now()));
+    EXPECT_EQ(read("swappiness"), "100");
+}
+
+TEST_F(SwapTuneTest, WritesBackIdlePagesUnderPressure) {
+    write("zram0/backing_dev", "/dev/block/by-name/userdata");
+    write("zram0/bd_stat", "0 0 0");
+
+    SwapTune tune(mConfig);
+    auto start = steady_clock::now();
+
+    setPressure(30);
+    setSwap(1024 * 1024, 100 * 1024);
+
+    /* The first pass only marks pages idle. */
+    ASSERT_TRUE(tune.step(start));
+    EXPECT_EQ(read("zram0/idle"), "all");
+    EXPECT_FALSE(access(path("zram0/writeback").c_str(), F_OK) == 0);
+
+    ASSERT_TRUE(tune.step(start + mConfig.writebackInterval - seconds(1)));
+    EXPECT_FALSE(access(path("zram0/writeback").c_str(), F_OK) == 0);
+
+    ASSERT_TRUE(tune.step(start + mConfig.writebackInterval));
+    EXPECT_EQ(read("zram0/writeback"), "idle");
+}
+
+TEST_F(SwapTuneTest, NoWritebackWhenCalm) {
+    write("zram0/backing_dev", "/dev/block/by-name/userdata");
+
+    SwapTune tune(mConfig);
+    auto start = steady_clock::now();
+
+    ASSERT_TRUE(tune.step(start));
+    ASSERT_TRUE(tune.step(start + mConfig.writebackInterval));
+    EXPECT_FALSE(access(path("zram0/writeback").c_str(), F_OK) == 0);
+}
+
+TEST_F(SwapTuneTest, LoadsConfig) {
+    write("swap_tune.conf",
+          "# test\n"
+          "swappiness_min 40\n"
+          "swappiness_step 20\n"
+          "comp_algorithm.4g zstd\n"
+          "unknown_key 1\n");
+
+    SwapTuneConfig config;
+
+    ASSERT_TRUE(config.load(path("swap_tune.conf")));
+    EXPECT_EQ(config.swappinessMin, 40u);
+    EXPECT_EQ(config.swappinessStep, 20u);
+    EXPECT_EQ(config.compAlgorithms["4g"], "zstd");
+    EXPECT_FALSE(config.load(path("missing.conf")));
+}
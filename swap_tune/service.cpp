@@ -0,0 +1,54 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "SwapTune.h"
+
+#include <android-base/logging.h>
+
+#include <cstring>
+#include <unistd.h>
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [--boot] [-c config]\n", name);
+}
+
+int main(int argc, char** argv) {
+    const char* configPath = SWAP_TUNE_CONF;
+    bool boot = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--boot") == 0) {
+            boot = true;
+        } else if (strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            configPath = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+#ifdef __ANDROID__
+    /* logd isn't up yet when zram is configured. */
+    if (boot) {
+        android::base::InitLogging(argv, android::base::KernelLogger);
+    }
+#endif
+
+    SwapTuneConfig config;
+    if (!config.load(configPath)) {
+        LOG(WARNING) << "no config at " << configPath << ", using defaults";
+    }
+
+    SwapTune tune(config);
+
+    if (boot) {
+        tune.configureZram();
+        return 0;
+    }
+
+    tune.run();
+    return 0;
+}
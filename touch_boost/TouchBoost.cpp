@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "TouchBoost.h"
+
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include <android-base/stringprintf.h>
+#include <android-base/strings.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+#include <memory>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/inotify.h>
+#include <sys/ioctl.h>
+#include <time.h>
+#include <unistd.h>
+
+using ::android::base::GetUintProperty;
+using ::android::base::StringAppendF;
+using ::android::base::StringPrintf;
+using std::chrono::duration_cast;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+using std::chrono::steady_clock;
+
+namespace {
+
+/* Tells the inotify fd apart from device fds in epoll. */
+constexpr uint64_t kInotifyTag = UINT64_MAX;
+
+constexpr size_t kBitsPerLong = sizeof(long) * 8;
+
+static bool testBit(const unsigned long* bits, unsigned int bit) {
+    return bits[bit / kBitsPerLong] & (1UL << (bit % kBitsPerLong));
+}
+
+static steady_clock::time_point eventTime(const input_event& event) {
+    return steady_clock::time_point(std::chrono::seconds(event.input_event_sec) +
+                                    microseconds(event.input_event_usec));
+}
+
+}  // anonymous namespace
+
+bool TouchBoost::isTouchscreen(int fd, const std::string& /* path */) {
+    unsigned long props[INPUT_PROP_CNT / kBitsPerLong + 1] = {};
+    unsigned long abs[ABS_CNT / kBitsPerLong + 1] = {};
+
+    if (ioctl(fd, EVIOCGPROP(sizeof(props)), props) < 0 ||
+        ioctl(fd, EVIOCGBIT(EV_ABS, sizeof(abs)), abs) < 0) {
+        return false;
+    }
+
+    return testBit(props, INPUT_PROP_DIRECT) && testBit(abs, ABS_MT_POSITION_X) &&
+           testBit(abs, ABS_MT_POSITION_Y);
+}
+
+void TouchBoostConfig::loadProperties() {
+    duration = milliseconds(GetUintProperty<uint32_t>("ro.vendor.touch_boost.duration_ms",
+                                                      duration.count(), kMaxDuration.count()));
+    debounce = milliseconds(
+            GetUintProperty<uint32_t>("ro.vendor.touch_boost.debounce_ms", debounce.count()));
+    statsInterval = std::chrono::seconds(GetUintProperty<uint32_t>(
+            "ro.vendor.touch_boost.stats_interval_s", statsInterval.count(), 86400));
+}
+
+TouchBoost::TouchBoost(const TouchBoostConfig& config, BoostFn boost, DeviceFilter filter)
+    : mConfig(config), mBoost(std::move(boost)), mFilter(std::move(filter)), mStats() {
+    mConfig.duration = std::min(mConfig.duration, TouchBoostConfig::kMaxDuration);
+}
+
+void TouchBoost::openDevice(const std::string& name) {
+    std::string path = mConfig.inputDir + "/" + name;
+    char deviceName[80] = "";
+    int clock = CLOCK_MONOTONIC;
+
+    for (const auto& [_, device] : mDevices) {
+        if (device.name == name) {
+            return;
+        }
+    }
+
+    android::base::unique_fd fd(open(path.c_str(), O_RDONLY | O_NONBLOCK | O_CLOEXEC));
+    if (fd.get() < 0) {
+        /* ueventd may not have set the permissions yet, IN_ATTRIB brings us back. */
+        PLOG(VERBOSE) << "failed to open " << path;
+        return;
+    }
+
+    if (!mFilter(fd.get(), path)) {
+        return;
+    }
+
+    /* Stamp events on the clock we measure latency against. */
+    if (ioctl(fd.get(), EVIOCSCLOCKID, &clock) < 0) {
+        PLOG(WARNING) << "failed to switch " << path << " to the monotonic clock";
+    }
+    ioctl(fd.get(), EVIOCGNAME(sizeof(deviceName) - 1), deviceName);
+
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = fd.get();
+    if (epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, fd.get(), &event) < 0) {
+        PLOG(ERROR) << "failed to watch " << path;
+        return;
+    }
+
+    LOG(INFO) << "watching " << path << " (" << deviceName << ")";
+
+    int key = fd.get();
+    mDevices[key] = {std::move(fd), name, false, 0, 0};
+}
+
+void TouchBoost::closeDevice(int fd) {
+    auto it = mDevices.find(fd);
+
+    if (it != mDevices.end()) {
+        LOG(INFO) << "lost " << mConfig.inputDir << "/" << it->second.name;
+        epoll_ctl(mEpoll.get(), EPOLL_CTL_DEL, fd, nullptr);
+        mDevices.erase(it);
+    }
+}
+
+void TouchBoost::scanDevices() {
+    std::unique_ptr<DIR, int (*)(DIR*)> dir(opendir(mConfig.inputDir.c_str()), closedir);
+
+    if (!dir) {
+        PLOG(ERROR) << "failed to list " << mConfig.inputDir;
+        return;
+    }
+
+    while (dirent* entry = readdir(dir.get())) {
+        if (android::base::StartsWith(entry->d_name, "event")) {
+            openDevice(entry->d_name);
+        }
+    }
+}
+
+void TouchBoost::handleInotify() {
+    alignas(inotify_event) char buffer[4096];
+    ssize_t length;
+
+    while ((length = read(mInotify.get(), buffer, sizeof(buffer))) > 0) {
+        for (char* p = buffer; p < buffer + length;) {
+            auto* event = reinterpret_cast<inotify_event*>(p);
+
+            if (event->len > 0 && android::base::StartsWith(event->name, "event")) {
+                openDevice(event->name);
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+    }
+}
+
+void TouchBoost::onTouchDown(const input_event& event) {
+    auto now = steady_clock::now();
+
+    mStats.touches++;
+
+    if (mStats.boosts > 0 && now - mLastBoost < mConfig.debounce) {
+        mStats.debounced++;
+        return;
+    }
+
+    if (!mBoost(mConfig.duration)) {
+        mStats.failed++;
+        return;
+    }
+
+    mLastBoost = now;
+    mStats.boosts++;
+
+    /* From the kernel stamping the touch to the boost being handed off. */
+    uint64_t us = std::max<int64_t>(
+            duration_cast<microseconds>(steady_clock::now() - eventTime(event)).count(), 1);
+    size_t bucket = std::min<size_t>(63 - __builtin_clzll(us), kLatencyBuckets - 1);
+
+    mStats.latencySumUs += us;
+    mStats.latencyMaxUs = std::max(mStats.latencyMaxUs, us);
+    mStats.latency[bucket]++;
+
+    LOG(VERBOSE) << "boosted " << mConfig.duration.count() << "ms, " << us << "us after touch";
+}
+
+void TouchBoost::handleEvents(Device& device) {
+    input_event events[64];
+    ssize_t length;
+
+    while ((length = read(device.fd.get(), events, sizeof(events))) > 0) {
+        for (size_t i = 0; i < length / sizeof(input_event); i++) {
+            const input_event& event = events[i];
+            bool idle = !device.buttonDown && device.contacts == 0;
+
+            if (event.type == EV_KEY && event.code == BTN_TOUCH) {
+                device.buttonDown = event.value != 0;
+            } else if (event.type == EV_ABS && event.code == ABS_MT_SLOT) {
+                device.slot = event.value;
+            } else if (event.type == EV_ABS && event.code == ABS_MT_TRACKING_ID &&
+                       device.slot >= 0 && device.slot < 64) {
+                if (event.value >= 0) {
+                    device.contacts |= 1ULL << device.slot;
+                } else {
+                    device.contacts &= ~(1ULL << device.slot);
+                }
+            } else {
+                continue;
+            }
+
+            /* Act on the first event of the gesture, not its SYN_REPORT. */
+            if (idle && (device.buttonDown || device.contacts != 0)) {
+                onTouchDown(event);
+            }
+        }
+    }
+
+    if (length < 0 && errno == ENODEV) {
+        closeDevice(device.fd.get());
+    }
+}
+
+void TouchBoost::logStats() {
+    std::string histogram;
+
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        if (mStats.latency[i] > 0) {
+            StringAppendF(&histogram, " %lluus:%" PRIu64, 1ULL << i, mStats.latency[i]);
+        }
+    }
+
+    LOG(INFO) << StringPrintf("stats touches=%" PRIu64 " boosts=%" PRIu64 " debounced=%" PRIu64
+                              " failed=%" PRIu64 " latency_avg=%" PRIu64 "us max=%" PRIu64 "us",
+                              mStats.touches, mStats.boosts, mStats.debounced, mStats.failed,
+                              mStats.boosts ? mStats.latencySumUs / mStats.boosts : 0,
+                              mStats.latencyMaxUs)
+              << (histogram.empty() ? "" : " histogram" + histogram);
+}
+
+bool TouchBoost::start() {
+    mEpoll.reset(epoll_create1(EPOLL_CLOEXEC));
+    mInotify.reset(inotify_init1(IN_NONBLOCK | IN_CLOEXEC));
+
+    if (mEpoll.get() < 0 || mInotify.get() < 0) {
+        return false;
+    }
+
+    if (inotify_add_watch(mInotify.get(), mConfig.inputDir.c_str(), IN_CREATE | IN_ATTRIB) < 0) {
+        PLOG(WARNING) << "failed to watch " << mConfig.inputDir << " for new devices";
+    } else {
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.u64 = kInotifyTag;
+        epoll_ctl(mEpoll.get(), EPOLL_CTL_ADD, mInotify.get(), &event);
+    }
+
+    scanDevices();
+    return true;
+}
+
+void TouchBoost::poll(milliseconds timeout) {
+    epoll_event events[8];
+    int count = epoll_wait(mEpoll.get(), events, 8, int(timeout.count()));
+
+    if (count < 0 && errno != EINTR) {
+        PLOG(ERROR) << "failed to wait for input";
+    }
+
+    for (int i = 0; i < count; i++) {
+        if (events[i].data.u64 == kInotifyTag) {
+            handleInotify();
+            continue;
+        }
+
+        auto it = mDevices.find(int(events[i].data.u64));
+        if (it == mDevices.end()) {
+            continue;
+        }
+
+        /* Read what is left before a hangup, a device closes on ENODEV anyway. */
+        if (events[i].events & EPOLLIN) {
+            handleEvents(it->second);
+        } else if (events[i].events & (EPOLLHUP | EPOLLERR)) {
+            closeDevice(it->first);
+        }
+    }
+}
+
+void TouchBoost::run() {
+    if (!start()) {
+        PLOG(FATAL) << "failed to set up epoll";
+    }
+
+    LOG(INFO) << "boosting INTERACTION for " << mConfig.duration.count() << "ms per touch, "
+              << mConfig.debounce.count() << "ms debounce";
+
+    auto lastStats = steady_clock::now();
+
+    for (;;) {
+        poll(duration_cast<milliseconds>(mConfig.statsInterval));
+
+        if (steady_clock::now() - lastStats >= mConfig.statsInterval) {
+            logStats();
+            lastStats = steady_clock::now();
+        }
+    }
+}
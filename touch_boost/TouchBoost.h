@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <linux/input.h>
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+
+#include <android-base/unique_fd.h>
+
+struct TouchBoostConfig {
+    /* Point this at a directory of uinput nodes to run on a plain Linux box. */
+    std::string inputDir = "/dev/input";
+
+    /* INTERACTION boost per touch-down, never longer than kMaxDuration. */
+    std::chrono::milliseconds duration{100};
+    /* Touch-downs this soon after the last boost are left alone. */
+    std::chrono::milliseconds debounce{50};
+    std::chrono::seconds statsInterval{600};
+
+    static constexpr std::chrono::milliseconds kMaxDuration{1000};
+
+    /* Reads the ro.vendor.touch_boost.* properties. */
+    void loadProperties();
+};
+
+/*
+ * Raises the INTERACTION hint on the first touch-down of a gesture, before
+ * the framework gets to it. Touchscreens are found by INPUT_PROP_DIRECT and
+ * multitouch axes, including ones that show up later.
+ */
+class TouchBoost {
+  public:
+    /* Applies the boost for the given duration, false if that failed. */
+    using BoostFn = std::function<bool(std::chrono::milliseconds)>;
+    /* Whether the input device at path, open as fd, is one to watch. */
+    using DeviceFilter = std::function<bool(int fd, const std::string& path)>;
+
+    TouchBoost(const TouchBoostConfig& config, BoostFn boost,
+               DeviceFilter filter = isTouchscreen);
+
+    /* Watch for touches until killed. */
+    void run();
+
+    /* The steps of run(): start watching, then handle input as it comes. */
+    bool start();
+    void poll(std::chrono::milliseconds timeout);
+
+    /* A screen reporting absolute multitouch positions, not a touchpad or a pen. */
+    static bool isTouchscreen(int fd, const std::string& path);
+
+  private:
+    struct Device {
+        android::base::unique_fd fd;
+        std::string name;
+        bool buttonDown;
+        int slot;
+        /* Slots with a contact, touch protocol B. */
+        uint64_t contacts;
+    };
+
+    /* Bucket i holds latencies in [2^i, 2^(i+1)) us, the last one is open-ended. */
+    static constexpr size_t kLatencyBuckets = 16;
+
+    struct Stats {
+        uint64_t touches;
+        uint64_t boosts;
+        uint64_t debounced;
+        uint64_t failed;
+        uint64_t latencySumUs;
+        uint64_t latencyMaxUs;
+        std::array<uint64_t, kLatencyBuckets> latency;
+    };
+
+    void scanDevices();
+    void openDevice(const std::string& name);
+    void closeDevice(int fd);
+    void handleInotify();
+    void handleEvents(Device& device);
+    void onTouchDown(const input_event& event);
+    void logStats();
+
+    TouchBoostConfig mConfig;
+    BoostFn mBoost;
+    DeviceFilter mFilter;
+    android::base::unique_fd mEpoll;
+    android::base::unique_fd mInotify;
+    std::map<int, Device> mDevices;
+
+    std::chrono::steady_clock::time_point mLastBoost;
+    Stats mStats;
+};
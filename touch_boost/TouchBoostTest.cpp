@@ -0,0 +1,264 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "TouchBoost.h"
+
+#include <android-base/file.h>
+#include <android-base/strings.h>
+#include <android-base/unique_fd.h>
+#include <gtest/gtest.h>
+
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+using android::base::EndsWith;
+using android::base::unique_fd;
+using std::chrono::milliseconds;
+
+// Feeds input_events through FIFOs standing in for /dev/input nodes
+class TouchBoostTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        mConfig.inputDir = mDir.path;
+        mConfig.duration = milliseconds(100);
+        mConfig.debounce = milliseconds(0);
+    }
+
+    /* Anything but the fake keyboard counts as a touchscreen. */
+    void start() {
+        mBoost = std::make_unique<TouchBoost>(
+                mConfig,
+                [this](milliseconds duration) {
+                    mDurations.push_back(duration);
+                    return !mFailBoost;
+                },
+                [](int, const std::string& path) { return !EndsWith(path, "event9"); });
+        ASSERT_TRUE(mBoost->start());
+    }
+
+    std::string path(const char* name) { return std::string(mDir.path) + "/" + name; }
+
+    void addDevice(const char* name) { ASSERT_EQ(mkfifo(path(name).c_str(), 0600), 0); }
+
+    /* Fails if nothing reads the device, like a writer on an unwatched FIFO. */
+    unique_fd connect(const char* name) {
+        return unique_fd(open(path(name).c_str(), O_WRONLY | O_NONBLOCK | O_CLOEXEC));
+    }
+
+    void send(const unique_fd& fd, std::vector<input_event> events) {
+        timespec now;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        for (auto& event : events) {
+            event.input_event_sec = now.tv_sec;
+            event.input_event_usec = now.tv_nsec / 1000;
+        }
+        events.push_back(ev(EV_SYN, SYN_REPORT, 0));
+
+        size_t size = events.size() * sizeof(input_event);
+        ASSERT_EQ(write(fd.get(), events.data(), size), ssize_t(size));
+        mBoost->poll(milliseconds(100));
+    }
+
+    static input_event ev(uint16_t type, uint16_t code, int32_t value) {
+        input_event event = {};
+
+        event.type = type;
+        event.code = code;
+        event.value = value;
+        return event;
+    }
+
+    /* Protocol B contact on slot, with BTN_TOUCH following the first one. */
+    static std::vector<input_event> down(int slot, int id, bool button = true) {
+        std::vector<input_event> events = {ev(EV_ABS, ABS_MT_SLOT, slot),
+                                           ev(EV_ABS, ABS_MT_TRACKING_ID, id)};
+        if (button) {
+            events.push_back(ev(EV_KEY, BTN_TOUCH, 1));
+        }
+        return events;
+    }
+
+    static std::vector<input_event> up(int slot, bool button = true) {
+        std::vector<input_event> events = {ev(EV_ABS, ABS_MT_SLOT, slot),
+                                           ev(EV_ABS, ABS_MT_TRACKING_ID, -1)};
+        if (button) {
+            events.push_back(ev(EV_KEY, BTN_TOUCH, 0));
+        }
+        return events;
+    }
+
+    TemporaryDir mDir;
+    TouchBoostConfig mConfig;
+    std::unique_ptr<TouchBoost> mBoost;
+    std::vector<milliseconds> mDurations;
+    bool mFailBoost = false;
+};
+
+TEST_F(TouchBoostTest, TapBoostsOnce) {
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+    ASSERT_GE(touch.get(), 0);
+
+    send(touch, down(0, 1));
+    ASSERT_EQ(mDurations.size(), 1u);
+    EXPECT_EQ(mDurations[0], milliseconds(100));
+
+    /* Movement and the lift are part of the same gesture */
+    send(touch, {ev(EV_ABS, ABS_MT_POSITION_X, 10), ev(EV_ABS, ABS_MT_POSITION_Y, 20)});
+    send(touch, up(0));
+    EXPECT_EQ(mDurations.size(), 1u);
+
+    send(touch, down(0, 2));
+    EXPECT_EQ(mDurations.size(), 2u);
+}
+
+TEST_F(TouchBoostTest, DurationIsCapped) {
+    mConfig.duration = milliseconds(5000);
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    send(touch, down(0, 1));
+    ASSERT_EQ(mDurations.size(), 1u);
+    EXPECT_EQ(mDurations[0], TouchBoostConfig::kMaxDuration);
+}
+
+TEST_F(TouchBoostTest, TapsWithinDebounceAreSkipped) {
+    mConfig.debounce = milliseconds(10000);
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    send(touch, down(0, 1));
+    send(touch, up(0));
+    send(touch, down(0, 2));
+    send(touch, up(0));
+
+    EXPECT_EQ(mDurations.size(), 1u);
+}
+
+TEST_F(TouchBoostTest, TapsAfterDebounceBoost) {
+    mConfig.debounce = milliseconds(20);
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    send(touch, down(0, 1));
+    send(touch, up(0));
+    usleep(50000);
+    send(touch, down(0, 2));
+
+    EXPECT_EQ(mDurations.size(), 2u);
+}
+
+TEST_F(TouchBoostTest, FailedBoostIsNotDebounced) {
+    mConfig.debounce = milliseconds(10000);
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    mFailBoost = true;
+    send(touch, down(0, 1));
+    send(touch, up(0));
+    mFailBoost = false;
+    send(touch, down(0, 2));
+    send(touch, up(0));
+    send(touch, down(0, 3));
+
+    /* The failed one, the retry, then debounced */
+    EXPECT_EQ(mDurations.size(), 2u);
+}
+
+TEST_F(TouchBoostTest, SecondFingerIsTheSameGesture) {
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    send(touch, down(0, 1));
+    /* BTN_TOUCH stays down while more fingers come and go */
+    send(touch, down(1, 2, false));
+    send(touch, up(0, false));
+    send(touch, down(0, 3, false));
+    EXPECT_EQ(mDurations.size(), 1u);
+
+    send(touch, up(0, false));
+    send(touch, up(1));
+    send(touch, down(1, 4));
+    EXPECT_EQ(mDurations.size(), 2u);
+}
+
+TEST_F(TouchBoostTest, ProtocolBWithoutButton) {
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+
+    send(touch, down(0, 1, false));
+    EXPECT_EQ(mDurations.size(), 1u);
+
+    send(touch, down(1, 2, false));
+    send(touch, up(0, false));
+    EXPECT_EQ(mDurations.size(), 1u);
+
+    /* Still one contact left on slot 1 */
+    send(touch, down(0, 3, false));
+    EXPECT_EQ(mDurations.size(), 1u);
+
+    send(touch, up(0, false));
+    send(touch, up(1, false));
+    send(touch, down(0, 4, false));
+    EXPECT_EQ(mDurations.size(), 2u);
+}
+
+TEST_F(TouchBoostTest, OtherDevicesAreIgnored) {
+    addDevice("event9");
+    addDevice("mouse0");
+    start();
+
+    /* Nobody reads them */
+    EXPECT_LT(connect("event9").get(), 0);
+    EXPECT_LT(connect("mouse0").get(), 0);
+}
+
+TEST_F(TouchBoostTest, HotpluggedDeviceIsWatched) {
+    start();
+
+    addDevice("event1");
+    mBoost->poll(milliseconds(100));
+    unique_fd touch = connect("event1");
+    ASSERT_GE(touch.get(), 0);
+
+    send(touch, down(0, 1));
+    EXPECT_EQ(mDurations.size(), 1u);
+}
+
+TEST_F(TouchBoostTest, UnpluggedDeviceIsDropped) {
+    addDevice("event0");
+    start();
+    unique_fd touch = connect("event0");
+    ASSERT_GE(touch.get(), 0);
+
+    /* A hangup closes the device once its events are read */
+    send(touch, down(0, 1));
+    touch.reset();
+    mBoost->poll(milliseconds(100));
+    EXPECT_LT(connect("event0").get(), 0);
+
+    /* Replugging it under the same name opens it again */
+    ASSERT_EQ(unlink(path("event0").c_str()), 0);
+    addDevice("event0");
+    mBoost->poll(milliseconds(100));
+    touch = connect("event0");
+    ASSERT_GE(touch.get(), 0);
+
+    send(touch, up(0));
+    send(touch, down(0, 2));
+    EXPECT_EQ(mDurations.size(), 2u);
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2023 The LineageOS Project
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "TouchBoost.h"
+
+#include <android-base/logging.h>
+
+#include <cstring>
+#include <unistd.h>
+
+#ifdef __ANDROID__
+#include <aidl/android/hardware/power/IPower.h>
+#include <android/binder_manager.h>
+
+using aidl::android::hardware::power::Boost;
+using aidl::android::hardware::power::IPower;
+
+static std::shared_ptr<IPower> getPower(bool wait) {
+    const std::string instance = std::string(IPower::descriptor) + "/default";
+    ndk::SpAIBinder binder(wait ? AServiceManager_waitForService(instance.c_str())
+                                : AServiceManager_checkService(instance.c_str()));
+
+    return IPower::fromBinder(binder);
+}
+#endif
+
+static void usage(const char* name) {
+    fprintf(stderr, "usage: %s [--dry-run] [-d input_dir]\n", name);
+}
+
+int main(int argc, char** argv) {
+    TouchBoostConfig config;
+    bool dryRun = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--dry-run") == 0) {
+            dryRun = true;
+        } else if (strcmp(argv[i], "-d") == 0 && i + 1 < argc) {
+            config.inputDir = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    config.loadProperties();
+
+    TouchBoost::BoostFn boost = [](std::chrono::milliseconds duration) {
+        LOG(INFO) << "would boost INTERACTION for " << duration.count() << "ms";
+        return true;
+    };
+
+#ifdef __ANDROID__
+    /*
+     * Go through the Power HAL so libperfmgr stays the only writer of the
+     * powerhint.json nodes.
+     */
+    std::shared_ptr<IPower> power;
+
+    if (!dryRun) {
+        power = getPower(true);
+        boost = [&power](std::chrono::milliseconds duration) {
+            if (power && power->setBoost(Boost::INTERACTION, duration.count()).isOk()) {
+                return true;
+            }
+
+            /* The HAL restarted, pick it up again for the next touch. */
+            power = getPower(false);
+            return false;
+        };
+    }
+#else
+    (void)dryRun;
+#endif
+
+    TouchBoost(config, boost).run();
+    return 0;
+}